@@ -1,15 +1,18 @@
 #include <iostream>
 #include <fstream>
 #include <time.h>
+#include <algorithm>
 #include "AVLTree.h"
 
 //https://visualgo.net/en/bst
 
 using namespace std;
 
-AVLTree::AVLTree() 
+AVLTree::AVLTree(bool counted) 
 {
 	root = NULL;
+	finger = NULL;
+	countKeys = counted;
 }
 
 AVLTree::~AVLTree() {}
@@ -19,31 +22,41 @@ AVLTree::~AVLTree() {}
 //
 // Private 
 //
-// Purpose: Inserts a node into a binary tree
+// Purpose: Inserts a node into a binary tree, then fixes heights and
+//          rebalances on the way back up, so only the nodes on the
+//          insertion path are touched.
 //
 // Arguments: reference to the root, and a reference to the new node
 //
 // Returns: Nothing.
 //*************************************************************************
 
-void AVLTree::insert(node *&nodePtr, node *&newNode) 
+void AVLTree::insert(node *&nodePtr, node *&newNode, int depth) 
 {
 	if (nodePtr == NULL) 
 	{
 		nodePtr = newNode;
+
+		return;
 	}
-	else if (newNode->value <= nodePtr->value)
+
+	instrument.visit(depth);
+	instrument.compare();
+
+	if (newNode->value <= nodePtr->value)
 	{
 		newNode->parent = nodePtr;
 
-		insert(nodePtr->left, newNode);
+		insert(nodePtr->left, newNode, depth + 1);
 	}
 	else 
 	{
 		newNode->parent = nodePtr;
 
-		insert(nodePtr->right, newNode);
+		insert(nodePtr->right, newNode, depth + 1);
 	}
+
+	rebalance(nodePtr);
 }
 
 //************************************************************************
@@ -55,20 +68,47 @@ void AVLTree::insert(node *&nodePtr, node *&newNode)
 //          calls insert to actually travers the binary tree and link the node in
 //          proper location. 
 //
-// Arguments: integer to be placed in binary tree.
+//          In counted-key mode a word already in the tree just bumps the
+//          count on its node instead of growing the tree.
+//
+// Arguments: word to be placed in binary tree, and how many times to add
+//            it (used when merging counts gathered elsewhere).
 //
 // Returns: Nothing.
 //*************************************************************************
 
-void AVLTree::insert(string word)
+void AVLTree::insert(string word, int times)
 {
-	node *newNode;
+	instrument.begin();
 
-	newNode = new node(word);
+	if (countKeys)
+	{
+		node *found = findNode(word);
 
-	insert(root, newNode);
+		if (found)
+		{
+			found->count += times;
+			return;
+		}
+	}
+
+	if (countKeys)
+	{
+		node *newNode = new node(word);
 
-	computeAvlValues(root);
+		instrument.allocate();
+		newNode->count = times;
+		insert(root, newNode);
+		return;
+	}
+
+	for (int i = 0; i < times; i++)
+	{
+		node *newNode = new node(word);
+
+		instrument.allocate();
+		insert(root, newNode);
+	}
 }
 
 //************************************************************************
@@ -135,8 +175,14 @@ int AVLTree::Search(string word)
 {
 	node *nodePtr = root;
 	int count = 1;
+
+	instrument.begin();
+
 	while (nodePtr)
 	{
+		instrument.visit(count);
+		instrument.compare();
+
 		if (nodePtr->value == word)
 			return count;
 
@@ -155,46 +201,288 @@ int AVLTree::Search(string word)
 	return 0;
 }
 
+//************************************************************************
+// Method Name: fingerSearch
+//
+// Public
+//
+// Purpose: Search for sorted or clustered query streams. Instead of
+//          starting at the root it starts at the node the previous
+//          fingerSearch ended on (the finger) and climbs the parent
+//          pointers only until it reaches an ancestor whose subtree must
+//          hold the word, then walks down as Search does. Climbing in
+//          the direction of the word needs no comparisons; an ancestor
+//          is only compared when the path turns. For m sorted queries
+//          this costs O(m log(n/m)) comparisons instead of O(m log n).
+//
+//          The finger moves to the node found, or to the last node
+//          looked at on a miss. remove() and resetFinger() drop it, and
+//          the next search starts from the root.
+//
+// Arguments: word to look for
+//
+// Returns: number of comparisons if found, 0 otherwise
+//*************************************************************************
+
+int AVLTree::fingerSearch(string word)
+{
+	node *nodePtr = finger ? finger : root;
+	int count = 1;
+
+	instrument.begin();
+
+	if (!nodePtr)
+		return 0;
+
+	instrument.visit(count);
+	instrument.compare();
+
+	int result = word.compare(nodePtr->value);
+
+	if (result == 0)
+		return count;
+
+	// climb until the word is known to lie under nodePtr
+
+	while (nodePtr->parent)
+	{
+		node *up = nodePtr->parent;
+
+		// still heading away from up: the word is past it too
+
+		if ((up->left == nodePtr) == (result < 0))
+		{
+			nodePtr = up;
+			continue;
+		}
+
+		count++;
+		instrument.visit(count);
+		instrument.compare();
+
+		int upResult = word.compare(up->value);
+
+		if (upResult == 0)
+		{
+			finger = up;
+			return count;
+		}
+
+		// up bounds the word on the other side: it is under nodePtr
+
+		if ((upResult < 0) != (result < 0))
+			break;
+
+		nodePtr = up;
+		result = upResult;
+	}
+
+	// ordinary descent from nodePtr, whose comparison is already known
+
+	node *next = result < 0 ? nodePtr->left : nodePtr->right;
+
+	while (next)
+	{
+		nodePtr = next;
+		count++;
+		instrument.visit(count);
+		instrument.compare();
+
+		result = word.compare(nodePtr->value);
+
+		if (result == 0)
+		{
+			finger = nodePtr;
+			return count;
+		}
+
+		next = result < 0 ? nodePtr->left : nodePtr->right;
+	}
+
+	finger = nodePtr;
+	return 0;
+}
+
+//************************************************************************
+// Method Name: findNode
+//
+// Private 
+//
+// Purpose: Same walk as Search, but hands back the node itself
+//
+// Arguments: word to look for
+//
+// Returns: pointer to the node holding word, NULL if not found
+//*************************************************************************
+
+node* AVLTree::findNode(string word)
+{
+	node *nodePtr = root;
+	int depth = 1;
+
+	while (nodePtr)
+	{
+		instrument.visit(depth++);
+		instrument.compare();
+
+		if (nodePtr->value == word)
+			return nodePtr;
+
+		else if (word < nodePtr->value)
+			nodePtr = nodePtr->left;
+
+		else
+			nodePtr = nodePtr->right;
+	}
+	return NULL;
+}
+
+//************************************************************************
+// Method Name: frequency
+//
+// Private 
+//
+// Purpose: Counts the occurrences of a word. Equal keys can end up on
+//          either side of each other after rotations, so once a match is
+//          found both of its subtrees are checked as well.
+//
+// Arguments: root of a (sub)tree, word to count
+//
+// Returns: number of times word was inserted (0 if never)
+//*************************************************************************
+
+int AVLTree::frequency(node *nodePtr, string word, int depth)
+{
+	if (!nodePtr)
+		return 0;
+
+	instrument.visit(depth);
+	instrument.compare();
+
+	if (word < nodePtr->value)
+		return frequency(nodePtr->left, word, depth + 1);
+
+	if (word > nodePtr->value)
+		return frequency(nodePtr->right, word, depth + 1);
+
+	return nodePtr->count + frequency(nodePtr->left, word, depth + 1) + frequency(nodePtr->right, word, depth + 1);
+}
+
+//************************************************************************
+// Method Name: topK
+//
+// Public 
+//
+// Purpose: Finds the k most frequent words. An inorder walk visits equal
+//          keys back to back, so each run of equal keys is totalled and
+//          offered to a min-heap that holds the best k seen so far.
+//
+// Arguments: number of words wanted
+//
+// Returns: (word, count) pairs, most frequent first
+//*************************************************************************
+
+void AVLTree::topK(node *nodePtr, int k, vector<pair<string, int> > &best, string &runWord, int &runCount)
+{
+	if (nodePtr)
+	{
+		topK(nodePtr->left, k, best, runWord, runCount);
+
+		if (runCount > 0 && nodePtr->value == runWord)
+		{
+			runCount += nodePtr->count;
+		}
+		else
+		{
+			if (runCount > 0)
+				offerTopK(best, k, runWord, runCount);
+
+			runWord = nodePtr->value;
+			runCount = nodePtr->count;
+		}
+
+		topK(nodePtr->right, k, best, runWord, runCount);
+	}
+}
+
+vector<pair<string, int> > AVLTree::topK(int k)
+{
+	vector<pair<string, int> > best;
+	string runWord = "";
+	int runCount = 0;
+
+	if (k <= 0)
+		return best;
+
+	topK(root, k, best, runWord, runCount);
+
+	if (runCount > 0)
+		offerTopK(best, k, runWord, runCount);
+
+	sort(best.begin(), best.end(), moreFrequent);
+
+	return best;
+}
+
 //************************************************************************
 // Method Name: remove
 //
 // Private 
 //
 // Purpose: Actually removes a node from a tree by pointer manipulation and
-//          frees the memory
+//          frees the memory, rebalancing the path back up to the root
 //
 // Arguments: address of node to be deleted
 //
 // Returns: void 
 //*************************************************************************
 
-node* AVLTree::remove(node*& root, string key)
+node* AVLTree::remove(node*& root, string key, int depth)
 {
 	if (!root)
 	{
 		return NULL;
 	}
 
+	instrument.visit(depth);
+	instrument.compare();
+
 	if (key < root->value)
 	{
+#ifdef TREE_TRACE
 		cout << "going left" << endl;
+#endif
 
-		root->left = remove(root->left, key);
+		root->left = remove(root->left, key, depth + 1);
 	}
 
 	else if (key > root->value)
 	{
+#ifdef TREE_TRACE
 		cout << "going right" << endl;
+#endif
 
-		root->right = remove(root->right, key);
+		root->right = remove(root->right, key, depth + 1);
 	}
 
 	else
 	{
+		// counted-key mode: drop one occurrence, keep the node
+
+		if (countKeys && root->count > 1)
+		{
+			root->count--;
+
+			return root;
+		}
+
 		if (root->left == NULL)
 		{
 			node *temp = root->right;
 
+			if (temp)
+				temp->parent = root->parent;
+
 			delete root;
 
 			return temp;
@@ -204,6 +492,8 @@ node* AVLTree::remove(node*& root, string key)
 		{
 			node *temp = root->left;
 
+			temp->parent = root->parent;
+
 			delete root;
 
 			return temp;
@@ -214,16 +504,25 @@ node* AVLTree::remove(node*& root, string key)
 
 		node *temp = predSuccessor(root);
 
+#ifdef TREE_TRACE
 		printNode(temp, "predSuccessor");
+#endif
 
 		// Copy the inorder successor's content to this node
 
 		root->value = temp->value;
 
+		root->count = temp->count;
+
+		temp->count = 1;
+
 		// Delete the inorder successor
 
-		root->right = remove(root->right, temp->value);
+		root->right = remove(root->right, temp->value, depth + 1);
 	}
+
+	rebalance(root);
+
 	return root;
 }
 
@@ -290,52 +589,63 @@ node* AVLTree::predSuccessor(node *root)
 //
 // Private 
 //
-// Purpose: Actually removes a node from a tree by pointer manipulation and
-//          frees the memory
+// Purpose: Height of a subtree, as kept up to date in each node by
+//          updateHeight
 //
 // Arguments: address of the root of the tree (or subtree)
 //
-// Returns: void 
+// Returns: number of levels, 0 for an empty subtree
 //*************************************************************************
 
 int AVLTree::height(node *nodePtr) {
 
-	int left_height = 0;
-
-	int right_height = 0;
-
 	if (nodePtr == NULL)
 		return 0;
 
-	else 
-	{
-		left_height = height(nodePtr->left);
+	return nodePtr->height;
+}
 
-		right_height = height(nodePtr->right);
-	}
+//************************************************************************
+// Method Name: treeHeight
+//
+// Public 
+//
+// Purpose: Height of the whole tree, from the iterative shape pass so
+//          deep trees can't overflow the call stack
+//
+// Arguments: none
+//
+// Returns: number of levels in the tree
+//*************************************************************************
 
-	if (left_height>right_height)
-		return 1 + left_height;
+int AVLTree::treeHeight() 
+{
+	return shape().height;
+}
 
-	else
-		return 1 + right_height;
+static string levelKey(node *n)
+{
+	return n->value;
 }
 
 //************************************************************************
-// Method Name: treeHeight
+// Method Name: levelOrderOut
 //
 // Public 
 //
-// Purpose: Public method to call the private height method
+// Purpose: Writes the tree breadth first, one line per level, streaming
+//          a level at a time (see writeLevelOrder)
 //
-// Arguments: none
+// Arguments: file to write to
 //
 // Returns: void 
 //*************************************************************************
 
-int AVLTree::treeHeight() 
+void AVLTree::levelOrderOut(string filename)
 {
-	return height(root);
+	ofstream out(filename);
+
+	writeLevelOrder(root, out, levelKey);
 }
 
 
@@ -358,35 +668,51 @@ int AVLTree::avlValue(node *nodePtr)
 }
 
 //************************************************************************
-// Method Name: computeAvlValues
+// Method Name: updateHeight
 //
 // Private 
 //
-// Purpose: Private method to calculate the avl values of the entire tree.
+// Purpose: Recomputes a node's height and avl value from its children,
+//          which must already be correct.
 //
 // Arguments: address of a node
 //
 // Returns: void 
 //*************************************************************************
 
-void AVLTree::computeAvlValues(node *&nodePtr)
+void AVLTree::updateHeight(node *nodePtr)
 {
-	if (nodePtr) 
-	{
-		computeAvlValues(nodePtr->left);
+	nodePtr->height = 1 + max(height(nodePtr->left), height(nodePtr->right));
 
-		computeAvlValues(nodePtr->right);
+	nodePtr->avlValue = avlValue(nodePtr);
+}
+
+//************************************************************************
+// Method Name: rebalance
+//
+// Private 
+//
+// Purpose: Fixes up one node after one of its subtrees changed height by
+//          at most one, rotating it if it is now out of balance. Called
+//          for each node on the path back up from an insert or remove.
+//
+// Arguments: reference to the pointer holding the node (it may be
+//            replaced by a rotation)
+//
+// Returns: void 
+//*************************************************************************
 
-		nodePtr->avlValue = avlValue(nodePtr);
+void AVLTree::rebalance(node *&nodePtr)
+{
+	updateHeight(nodePtr);
 
-		if (nodePtr->avlValue > 1) 
-		{
-			rotateLeft(nodePtr);
-		}
-		else if (nodePtr->avlValue < -1) 
-		{
-			rotateRight(nodePtr);
-		}
+	if (nodePtr->avlValue > 1) 
+	{
+		rotateLeft(nodePtr);
+	}
+	else if (nodePtr->avlValue < -1) 
+	{
+		rotateRight(nodePtr);
 	}
 }
 
@@ -396,6 +722,9 @@ void AVLTree::computeAvlValues(node *&nodePtr)
 // Private 
 //
 // Purpose: Private method to perform a left rotation from a given position in a tree
+//          (a double rotation if the child leans the other way). Parent
+//          pointers, heights and avl values of the moved nodes are kept
+//          up to date.
 //
 // Arguments: address of a node
 //
@@ -411,23 +740,37 @@ void AVLTree::rotateLeft(node *&SubRoot)
 
 	node *Temp;
 
+	instrument.rotate();
+
 	Temp = SubRoot->right;
 
 	SubRoot->right = Temp->left;
 
+	if (Temp->left)
+		Temp->left->parent = SubRoot;
+
 	Temp->left = SubRoot;
 
+	Temp->parent = SubRoot->parent;
+
+	SubRoot->parent = Temp;
+
 	SubRoot = Temp;
 
-	computeAvlValues(SubRoot);
+	updateHeight(SubRoot->left);
+
+	updateHeight(SubRoot);
 }
 
 //************************************************************************
-// Method Name: rotateLeft 
+// Method Name: rotateRight 
 //
 // Private 
 //
 // Purpose: Private method to perform a right rotation from a given position in a tree
+//          (a double rotation if the child leans the other way). Parent
+//          pointers, heights and avl values of the moved nodes are kept
+//          up to date.
 //
 // Arguments: address of a node
 //
@@ -443,99 +786,51 @@ void AVLTree::rotateRight(node *&SubRoot)
 
 	node *Temp;
 
+	instrument.rotate();
+
 	Temp = SubRoot->left;
 
 	SubRoot->left = Temp->right;
 
-	Temp->right = SubRoot;
+	if (Temp->right)
+		Temp->right->parent = SubRoot;
 
-	SubRoot = Temp;
+	Temp->right = SubRoot;
 
-	computeAvlValues(SubRoot);
-}
+	Temp->parent = SubRoot->parent;
 
-//************************************************************************
-// Method to help create GraphViz code so the expression tree can 
-// be visualized. This method prints out all the unique node id's
-// by traversing the tree.
-// Recivies a node pointer to root and performs a simple recursive 
-// tree traversal.
-//************************************************************************
+	SubRoot->parent = Temp;
 
-void AVLTree::graphVizGetIds(node *nodePtr, ofstream &VizOut) 
-{
-	static int NullCount = 0;
+	SubRoot = Temp;
 
-	if (nodePtr) 
-	{
-		graphVizGetIds(nodePtr->left, VizOut);
-		VizOut << "node" << nodePtr->value
-			<< "[label=\"" << nodePtr->value << "\\n"
-			<< "Avl:" << nodePtr->avlValue << "\\n"
-			//<<"Add:"<<nodePtr<<"\\n"
-			//<<"Par:"<<nodePtr->parent<<"\\n"
-			//<<"Rt:"<<nodePtr->right<<"\\n"
-			//<<"Lt:"<<nodePtr->left<<"\\n"
-			<< "\"]" << endl;
-
-		if (!nodePtr->left)
-		{
-			NullCount++;
-			VizOut << "nnode" << NullCount << "[label=\"X\",shape=point,width=.15]" << endl;
-		}
-		graphVizGetIds(nodePtr->right, VizOut);
+	updateHeight(SubRoot->right);
 
-		if (!nodePtr->right) 
-		{
-			NullCount++;
-			VizOut << "nnode" << NullCount << "[label=\"X\",shape=point,width=.15]" << endl;
-		}
-	}
+	updateHeight(SubRoot);
 }
 
 //************************************************************************
-// This method is partnered with the above method, but on this pass it 
-// writes out the actual data from each node.
-// Don't worry about what this method and the above method do, just
-// use the output as your told:)
+// Recieves a filename to place the GraphViz data into, and optionally a
+// depth and node budget to cap the output at (0 = whole tree).
+// The tree is written in a single iterative pass by writeGraphViz, so
+// running it twice on the same tree gives the same file.
 //************************************************************************
 
-void AVLTree::graphVizMakeConnections(node *nodePtr, ofstream &VizOut)
+static string vizLabel(node *nodePtr)
 {
-	static int NullCount = 0;
-	if (nodePtr) 
+	string label = nodePtr->value + "\\n" + "Avl:" + to_string(nodePtr->avlValue);
+
+	if (nodePtr->count > 1)
 	{
-		graphVizMakeConnections(nodePtr->left, VizOut);
-		if (nodePtr->left)
-			VizOut << "node" << nodePtr->value << "->" << "node" << nodePtr->left->value << endl;
-		else 
-		{
-			NullCount++;
-			VizOut << "node" << nodePtr->value << "->" << "nnode" << NullCount << endl;
-		}
-		if (nodePtr->right)
-			VizOut << "node" << nodePtr->value << "->" << "node" << nodePtr->right->value << endl;
-		else 
-		{
-			NullCount++;
-			VizOut << "node" << nodePtr->value << "->" << "nnode" << NullCount << endl;
-		}
-		graphVizMakeConnections(nodePtr->right, VizOut);
+		label += "\\nx" + to_string(nodePtr->count);
 	}
+	return label;
 }
 
-//************************************************************************
-// Recieves a filename to place the GraphViz data into.
-// It then calls the above two graphviz methods to create a data file
-// that can be used to visualize your expression tree.
-//************************************************************************
-
-void AVLTree::graphVizOut(string filename)
+void AVLTree::graphVizOut(string filename, int maxDepth, int maxNodes)
 {
 	ofstream VizOut;
 	VizOut.open(filename);
-	graphVizGetIds(root, VizOut);
-	graphVizMakeConnections(root, VizOut);
+	writeGraphViz(root, VizOut, vizLabel, maxDepth, maxNodes);
 	VizOut.close();
 }
 
@@ -3,6 +3,11 @@
 #include <fstream>
 #include <time.h>
 #include <string>
+#include <vector>
+#include "TreeStats.h"
+#include "TreeShape.h"
+#include "TreeTopK.h"
+#include "TreeViz.h"
 
 using namespace std;
 
@@ -14,12 +19,16 @@ struct node {
 	node *parent;
 
 	int avlValue;
+	int height;     // levels in the subtree rooted here (leaf = 1)
+	int count;      // occurrences of value (counted-key mode)
 
 	node(string word) 
 	{
 		value = word;
 		left = right = parent = NULL;
 		avlValue = 0;
+		height = 1;
+		count = 1;
 	}
 
 };
@@ -30,23 +39,30 @@ class AVLTree {
 
 private:
 	node *root;	
+	bool countKeys;	
+	node *finger;	// where the last fingerSearch ended
+	TreeInstrument instrument;
 	bool rightHeavy(node *);	
 	bool leftHeavy(node *);	
-	void insert(node *&, node *&);	
+	void insert(node *&, node *&, int = 1);	
+	node* findNode(string);
+	int  frequency(node *, string, int = 1);
+	void topK(node *, int, vector<pair<string, int> > &, string &, int &);
 	void inorder(node *);	
 	void preorder(node *);
 	void postorder(node *);
-	node* remove(node*&, string);
+	node* remove(node*&, string, int = 1);
 	node* predSuccessor(node*);
 	void printNode(node *, string);
 	int  height(node *);
-	void computeAvlValues(node *&);
+	void updateHeight(node *);
+	void rebalance(node *&);
 	void rotateLeft(node *&);
 	void rotateRight(node *&);
 	int  avlValue(node *);
 
 public:
-	AVLTree();
+	AVLTree(bool counted = false);
 	~AVLTree();
 	void doDumpTree(node *);
 	void dumpTree() {
@@ -55,15 +71,26 @@ public:
 		doDumpTree(root);
 	};
 
-	void insert(string);
+	void insert(string, int = 1);
 	void showInorder() { inorder(root); };
 	void showPreorder() { preorder(root); };
 	void showPostorder() { postorder(root); };
+
+	// calls visit(word, count) for every node in sorted order
+	template <class Visit>
+	void inorderWalk(Visit visit) { walkInorder(root, [&](node *n) { visit(n->value, n->count); }); };
 	int Search(string);
-	void remove(string word) { root = remove(root, word); };
+	int fingerSearch(string);
+	void resetFinger() { finger = NULL; };
+	int frequency(string word) { instrument.begin(); return frequency(root, word); };
+	vector<pair<string, int> > topK(int);
+	void remove(string word) { instrument.begin(); finger = NULL; root = remove(root, word); };
 	int  treeHeight();
-	void graphVizGetIds(node *, ofstream &);
-	void graphVizMakeConnections(node *, ofstream &);
-	void graphVizOut(string);
+	ShapeReport shape() { return measureShape(root); };
+	void levelOrderOut(string);
+	TreeStats stats() const { return instrument.totals(); };
+	TreeStats lastOpStats() const { return instrument.lastOp(); };
+	void resetStats() { instrument.reset(); };
+	void graphVizOut(string, int maxDepth = 0, int maxNodes = 0);
 };
 
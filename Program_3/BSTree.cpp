@@ -2,6 +2,7 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <algorithm>
 #include "BSTree.h"
 
 //http://www.webgraphviz.com/
@@ -12,8 +13,11 @@ int BSTree::Search(string word)
 {
 	Bnode *nodePtr = root;
 	int count = 1;
+	instrument.begin();
 	while (nodePtr)
 	{
+		instrument.visit(count);
+		instrument.compare();
 		if (nodePtr->data == word)
 			return count;
 
@@ -32,6 +36,32 @@ int BSTree::Search(string word)
 	return 0;
 }
 
+/* Same walk as Search, but hands back the node itself (NULL if missing) */
+
+Bnode *BSTree::findNode(string word)
+	{
+		Bnode *nodePtr = root;
+		int depth = 1;
+		while (nodePtr)
+		{
+			instrument.visit(depth++);
+			instrument.compare();
+			if (nodePtr->data == word)
+			{
+				return nodePtr;
+			}
+			else if (word < nodePtr->data)
+			{
+				nodePtr = nodePtr->left;
+			}
+			else
+			{
+				nodePtr = nodePtr->right;
+			}
+		}
+		return NULL;
+	}
+
 int BSTree::count(Bnode *root)
 	{
 		if (!root)
@@ -45,7 +75,7 @@ int BSTree::count(Bnode *root)
 		}
 	}
 
-void BSTree::insert(Bnode *&root, Bnode *&temp)
+void BSTree::insert(Bnode *&root, Bnode *&temp, int depth)
 	{
 		if (!root)
 		{
@@ -54,14 +84,16 @@ void BSTree::insert(Bnode *&root, Bnode *&temp)
 
 		else
 		{
+			instrument.visit(depth);
+			instrument.compare();
 			if (temp->data < root->data)
 			{
-				insert(root->left, temp);
+				insert(root->left, temp, depth + 1);
 			}
 
 			else
 			{
-				insert(root->right, temp);
+				insert(root->right, temp, depth + 1);
 			}
 		}
 	}
@@ -91,117 +123,58 @@ void BSTree::print_node(Bnode *n, string label = "")
 		}
 	}
 
-int BSTree::height(Bnode *root)
+/* Count occurrences of a word; equal keys always sit to the right */
+
+int BSTree::frequency(Bnode *root, string word, int depth)
 	{
 		if (!root)
 		{
 			return 0;
 		}
-		else
+		instrument.visit(depth);
+		instrument.compare();
+		if (word < root->data)
 		{
-			int left = height(root->left);
-			int right = height(root->right);
-			if (left > right)
-			{
-				return left + 1;
-			}
-			else
-			{
-				return right + 1;
-			}
+			return frequency(root->left, word, depth + 1);
 		}
-	}
-
-	/* Print nodes at a given level */
-
-void BSTree::printGivenLevel(Bnode *root, int level)
-	{
-		if (root == NULL)
-			return;
-		if (level == 1)
-		{
-			print_node(root);
-		}
-		else if (level > 1)
+		else if (word > root->data)
 		{
-			printGivenLevel(root->left, level - 1);
-			printGivenLevel(root->right, level - 1);
+			return frequency(root->right, word, depth + 1);
 		}
-	}
-
-//************************************************************************
-// Method to help create GraphViz code so the expression tree can
-// be visualized. This method prints out all the unique node id's
-// by traversing the tree.
-// Recivies a node pointer to root and performs a simple recursive
-// tree traversal.
-//************************************************************************
-
-void BSTree::GraphVizGetIds(Bnode *nodePtr, ofstream &VizOut)
-	{
-		static int NullCount = 0;
-		if (nodePtr)
+		else
 		{
-			GraphVizGetIds(nodePtr->left, VizOut);
-			VizOut << "node" << nodePtr->data
-				<< "[label=\"" << nodePtr->data << "\\n"
-				//<<"Add:"<<nodePtr<<"\\n"
-				//<<"Par:"<<nodePtr->parent<<"\\n"
-				//<<"Rt:"<<nodePtr->right<<"\\n"
-				//<<"Lt:"<<nodePtr->left<<"\\n"
-				<< "\"]" << endl;
-			if (!nodePtr->left)
-			{
-				NullCount++;
-				VizOut << "nnode" << NullCount << "[label=\"X\",shape=point,width=.15]" << endl;
-			}
-			GraphVizGetIds(nodePtr->right, VizOut);
-			if (!nodePtr->right)
-			{
-				NullCount++;
-				VizOut << "nnode" << NullCount << "[label=\"X\",shape=point,width=.15]" << endl;
-			}
+			return root->count + frequency(root->right, word, depth + 1);
 		}
 	}
 
-//************************************************************************
-// This method is partnered with the above method, but on this pass it
-// writes out the actual data from each node.
-// Don't worry about what this method and the above method do, just
-// use the output as your told:)
-//************************************************************************
+/* Inorder walk; equal keys come out back to back so each run is totalled */
 
-void BSTree::GraphVizMakeConnections(Bnode *nodePtr, ofstream &VizOut)
+void BSTree::topK(Bnode *root, int k, vector<pair<string, int> > &best, string &runWord, int &runCount)
 	{
-		static int NullCount = 0;
-		if (nodePtr)
+		if (root)
 		{
-			GraphVizMakeConnections(nodePtr->left, VizOut);
-			if (nodePtr->left)
-				VizOut << "node" << nodePtr->data << "->"
-				<< "node" << nodePtr->left->data << endl;
-			else
+			topK(root->left, k, best, runWord, runCount);
+			if (runCount > 0 && root->data == runWord)
 			{
-				NullCount++;
-				VizOut << "node" << nodePtr->data << "->"
-					<< "nnode" << NullCount << endl;
+				runCount += root->count;
 			}
-			if (nodePtr->right)
-				VizOut << "node" << nodePtr->data << "->"
-				<< "node" << nodePtr->right->data << endl;
 			else
 			{
-				NullCount++;
-				VizOut << "node" << nodePtr->data << "->"
-					<< "nnode" << NullCount << endl;
+				if (runCount > 0)
+				{
+					offerTopK(best, k, runWord, runCount);
+				}
+				runWord = root->data;
+				runCount = root->count;
 			}
-			GraphVizMakeConnections(nodePtr->right, VizOut);
+			topK(root->right, k, best, runWord, runCount);
 		}
 	}
 
-BSTree::BSTree()
+BSTree::BSTree(bool counted)
 	{
 		root = NULL;
+		countKeys = counted;
 	}
 
 BSTree::~BSTree()
@@ -214,10 +187,57 @@ int BSTree::count()
 		return count(root);
 	}
 
-void BSTree::insert(string x)
+/* times > 1 adds a word that many times (one node in counted mode) */
+
+void BSTree::insert(string x, int times)
+	{
+		instrument.begin();
+		if (countKeys)
+		{
+			Bnode *found = findNode(x);
+			if (found)
+			{
+				found->count += times;
+				return;
+			}
+			Bnode *temp = new Bnode(x);
+			instrument.allocate();
+			temp->count = times;
+			insert(root, temp);
+		}
+		else
+		{
+			for (int i = 0; i < times; i++)
+			{
+				Bnode *temp = new Bnode(x);
+				instrument.allocate();
+				insert(root, temp);
+			}
+		}
+	}
+
+int BSTree::frequency(string word)
+	{
+		instrument.begin();
+		return frequency(root, word);
+	}
+
+vector<pair<string, int> > BSTree::topK(int k)
 	{
-		Bnode *temp = new Bnode(x);
-		insert(root, temp);
+		vector<pair<string, int> > best;
+		string runWord = "";
+		int runCount = 0;
+		if (k <= 0)
+		{
+			return best;
+		}
+		topK(root, k, best, runWord, runCount);
+		if (runCount > 0)
+		{
+			offerTopK(best, k, runWord, runCount);
+		}
+		sort(best.begin(), best.end(), moreFrequent);
+		return best;
 	}
 
 int BSTree::height(string key = "")
@@ -228,7 +248,7 @@ int BSTree::height(string key = "")
 		}
 		else
 		{
-			return height(root);
+			return shape().height;
 		}
 		return 0;
 	}
@@ -241,34 +261,77 @@ string BSTree::top()
 			return 0;
 	}
 
+ShapeReport BSTree::shape()
+	{
+		return measureShape(root);
+	}
+
 	/* Function to line by line print level order traversal a tree*/
+	/* Breadth first with a queue, so each node is visited once */
 
 void BSTree::printLevelOrder()
 	{
 		cout << "Begin Level Order===================\n";
-		int h = height(root);
-		int i;
-		for (i = 1; i <= h; i++)
+		deque<Bnode *> level;
+		if (root)
+		{
+			level.push_back(root);
+		}
+		while (!level.empty())
 		{
-			printGivenLevel(root, i);
+			size_t width = level.size();
+			for (size_t i = 0; i < width; i++)
+			{
+				Bnode *n = level.front();
+				level.pop_front();
+				print_node(n);
+				if (n->left)
+				{
+					level.push_back(n->left);
+				}
+				if (n->right)
+				{
+					level.push_back(n->right);
+				}
+			}
 			cout << "\n";
 		}
 		cout << "End Level Order===================\n";
 	}
 
+static string levelKey(Bnode *n)
+	{
+		return n->data;
+	}
+
+	/* Level order dump to a file, one line per level (see writeLevelOrder) */
+
+void BSTree::levelOrderOut(string filename)
+	{
+		ofstream out(filename);
+		writeLevelOrder(root, out, levelKey);
+	}
+
 //************************************************************************
-// Recieves a filename to place the GraphViz data into.
-// It then calls the above two graphviz methods to create a data file
-// that can be used to visualize your expression tree.
+// Recieves a filename to place the GraphViz data into, and optionally a
+// depth and node budget to cap the output at (0 = whole tree).
+// The tree is written in a single iterative pass by writeGraphViz, so
+// running it twice on the same tree gives the same file.
 //************************************************************************
 
-void BSTree::GraphVizOut(string filename)
+static string vizLabel(Bnode *nodePtr)
+	{
+		if (nodePtr->count > 1)
+		{
+			return nodePtr->data + "\\nx" + to_string(nodePtr->count);
+		}
+		return nodePtr->data;
+	}
+
+void BSTree::GraphVizOut(string filename, int maxDepth, int maxNodes)
 	{
 		ofstream VizOut;
 		VizOut.open(filename);
-		VizOut << "Digraph G {\n";
-		GraphVizGetIds(root, VizOut);
-		GraphVizMakeConnections(root, VizOut);
-		VizOut << "}\n";
+		writeGraphViz(root, VizOut, vizLabel, maxDepth, maxNodes);
 		VizOut.close();
 	}
\ No newline at end of file
@@ -3,6 +3,10 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include "TreeStats.h"
+#include "TreeShape.h"
+#include "TreeTopK.h"
+#include "TreeViz.h"
 
 using namespace std;
 
@@ -10,12 +14,14 @@ struct Bnode {
 	string data;
 	Bnode *left;
 	Bnode *right;
+	int count;      // occurrences of data (counted-key mode)
 
 	Bnode()
 	{
 		data = "";
 		left = NULL;
 		right = NULL;
+		count = 1;
 	}
 
 	Bnode(string w)
@@ -23,6 +29,7 @@ struct Bnode {
 		data = w;
 		left = NULL;
 		right = NULL;
+		count = 1;
 	}
 };
 
@@ -30,22 +37,34 @@ class BSTree
 {
 private:
 	Bnode *root;
+	bool countKeys;
+	TreeInstrument instrument;
 
 	int count(Bnode *);
-	void insert(Bnode *&, Bnode *&);
+	Bnode *findNode(string);
+	int frequency(Bnode *, string, int = 1);
+	void topK(Bnode *, int, vector<pair<string, int> > &, string &, int &);
+	void insert(Bnode *&, Bnode *&, int = 1);
 	void print_node(Bnode *, string);
-	int height(Bnode *);
-	void printGivenLevel(Bnode *, int );
-	void GraphVizGetIds(Bnode *, ofstream &);
-	void GraphVizMakeConnections(Bnode *, ofstream &);
 public:
-	BSTree();
+	BSTree(bool counted = false);
 	~BSTree();
 	int Search(string);
 	int count();
-	void insert(string );
+	void insert(string, int = 1);
+	int frequency(string);
+	vector<pair<string, int> > topK(int);
 	int height(string);
 	string top();
 	void printLevelOrder();
-	void GraphVizOut(string);
+	void levelOrderOut(string);
+
+	// calls visit(word, count) for every node in sorted order
+	template <class Visit>
+	void inorderWalk(Visit visit) { walkInorder(root, [&](Bnode *n) { visit(n->data, n->count); }); };
+	ShapeReport shape();
+	void GraphVizOut(string, int maxDepth = 0, int maxNodes = 0);
+	TreeStats stats() const { return instrument.totals(); };
+	TreeStats lastOpStats() const { return instrument.lastOp(); };
+	void resetStats() { instrument.reset(); };
 };
\ No newline at end of file
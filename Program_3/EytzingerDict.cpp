@@ -0,0 +1,184 @@
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "EytzingerDict.h"
+
+using namespace std;
+
+// Hints that p will be read soon. Only GCC and Clang have a portable
+// builtin for it; elsewhere it does nothing.
+static inline void prefetch(const void *p)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	__builtin_prefetch(p);
+#else
+	(void)p;
+#endif
+}
+
+EytzingerDict::EytzingerDict()
+{
+	clear();
+}
+
+//************************************************************************
+// Method Name: clear
+//
+// Public
+//
+// Purpose: Empties the dictionary so it can be built again.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void EytzingerDict::clear()
+{
+	keys.clear();
+	keyStart.clear();
+	keyLength.clear();
+	sorted.clear();
+}
+
+//************************************************************************
+// Method Name: add
+//
+// Public
+//
+// Purpose: Adds the next word of a sorted sequence, skipping repeats.
+//
+// Arguments: word
+//
+// Returns: void
+//*************************************************************************
+
+void EytzingerDict::add(const string &word)
+{
+	if (sorted.empty() || sorted.back() != word)
+		sorted.push_back(word);
+}
+
+//************************************************************************
+// Method Name: place
+//
+// Private
+//
+// Purpose: Inorder walk of the implicit tree rooted at a slot, handing
+//          out the sorted words in order, so slot order is heap order.
+//
+// Arguments: slot, index of the next sorted word
+//
+// Returns: void
+//*************************************************************************
+
+void EytzingerDict::place(size_t slot, size_t &next)
+{
+	if (slot >= keyStart.size())
+		return;
+
+	place(2 * slot, next);
+
+	keyStart[slot] = (uint32_t)keys.length();
+	keyLength[slot] = (uint32_t)sorted[next].length();
+	keys += sorted[next++];
+
+	place(2 * slot + 1, next);
+}
+
+//************************************************************************
+// Method Name: finish
+//
+// Public
+//
+// Purpose: Lays the added words out in Eytzinger order.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void EytzingerDict::finish()
+{
+	size_t next = 0;
+
+	keys.clear();
+	keyStart.assign(sorted.size() + 1, 0);
+	keyLength.assign(sorted.size() + 1, 0);
+
+	place(1, next);
+
+	sorted.clear();
+	sorted.shrink_to_fit();
+}
+
+//************************************************************************
+// Method Name: compareSlot
+//
+// Private
+//
+// Purpose: Compares the word stored in a slot with a word.
+//
+// Arguments: slot, word
+//
+// Returns: <0, 0, >0 like string::compare
+//*************************************************************************
+
+int EytzingerDict::compareSlot(size_t slot, const string &word) const
+{
+	size_t length = keyLength[slot];
+	int result = memcmp(keys.data() + keyStart[slot], word.data(), min(length, word.length()));
+
+	if (result != 0)
+		return result;
+	if (length == word.length())
+		return 0;
+	return length < word.length() ? -1 : 1;
+}
+
+//************************************************************************
+// Method Name: Search
+//
+// Public
+//
+// Purpose: Walks down from slot 1. Slots 16i .. 16i + 15 are where the
+//          search will be four levels further down, and they share a
+//          cache line or two of keyStart and keyLength, so those are
+//          prefetched first. The word bytes of both children (whose
+//          keyStart was prefetched four levels ago) are prefetched too,
+//          so the next compare doesn't wait on keys.
+//
+// Arguments: word to look for
+//
+// Returns: number of comparisons if found, 0 otherwise
+//*************************************************************************
+
+int EytzingerDict::Search(string word)
+{
+	size_t n = size();
+	size_t slot = 1;
+	int count = 0;
+
+	while (slot <= n)
+	{
+		if (16 * slot <= n)
+		{
+			prefetch(&keyStart[16 * slot]);
+			prefetch(&keyLength[16 * slot]);
+		}
+		if (2 * slot <= n)
+			prefetch(keys.data() + keyStart[2 * slot]);
+		if (2 * slot + 1 <= n)
+			prefetch(keys.data() + keyStart[2 * slot + 1]);
+
+		count++;
+		int result = compareSlot(slot, word);
+
+		if (result == 0)
+			return count;
+
+		slot = 2 * slot + (result < 0);
+	}
+	return 0;
+}
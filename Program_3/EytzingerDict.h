@@ -0,0 +1,51 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+//************************************************************************
+// EytzingerDict - read-only sorted word set stored in Eytzinger (heap)
+// order: slot 1 holds the middle word, the children of slot i are 2i and
+// 2i + 1. A search walks the implicit tree with no pointers, and the
+// slots it will visit a few levels down sit next to each other, so they
+// can be prefetched while the current compare runs.
+//
+// This is the baseline for LearnedIndex. Search returns the number of key
+// comparisons like AVLTree::Search (0 = not found).
+//
+// Build it from a tree with build() (inorderWalk), or add() words in
+// sorted order and call finish(). Repeated words are stored once.
+//************************************************************************
+
+class EytzingerDict {
+
+private:
+	string keys;                // word bytes in slot order
+	vector<uint32_t> keyStart;  // keyStart[slot], slot 1..n
+	vector<uint32_t> keyLength;
+	vector<string> sorted;      // builder state
+
+	void place(size_t, size_t &);
+	int compareSlot(size_t, const string &) const;
+
+public:
+	EytzingerDict();
+
+	void clear();
+	void add(const string &);
+	void finish();
+
+	template <class Tree>
+	void build(Tree &T)
+	{
+		clear();
+		T.inorderWalk([this](const string &word, int) { add(word); });
+		finish();
+	}
+
+	int Search(string);
+	size_t size() const { return keyStart.empty() ? 0 : keyStart.size() - 1; };
+	size_t bytes() const { return keys.size() + (keyStart.size() + keyLength.size()) * sizeof(uint32_t); };
+};
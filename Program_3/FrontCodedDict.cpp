@@ -0,0 +1,310 @@
+#include <string>
+#include <vector>
+#include <cstring>
+#include "FrontCodedDict.h"
+
+using namespace std;
+
+FrontCodedDict::FrontCodedDict(int wordsPerBlock)
+{
+	blockSize = wordsPerBlock > 0 ? wordsPerBlock : 1;
+	clear();
+}
+
+//************************************************************************
+// Method Name: clear
+//
+// Public
+//
+// Purpose: Empties the dictionary so it can be built again.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void FrontCodedDict::clear()
+{
+	data.clear();
+	blockStart.clear();
+	previous.clear();
+	words = 0;
+	inBlock = 0;
+	pendingCount = 0;
+	pending = false;
+}
+
+//************************************************************************
+// Method Name: putVarint, getVarint
+//
+// Private
+//
+// Purpose: LEB128 style variable length integers, 7 bits per byte with
+//          the high bit set on every byte but the last.
+//
+//*************************************************************************
+
+void FrontCodedDict::putVarint(vector<char> &out, uint64_t value)
+{
+	while (value >= 0x80)
+	{
+		out.push_back((char)(value | 0x80));
+		value >>= 7;
+	}
+	out.push_back((char)value);
+}
+
+uint64_t FrontCodedDict::getVarint(const char *&p)
+{
+	uint64_t value = 0;
+	int shift = 0;
+
+	while ((unsigned char)*p & 0x80)
+	{
+		value |= (uint64_t)((unsigned char)*p & 0x7F) << shift;
+		shift += 7;
+		p++;
+	}
+	value |= (uint64_t)(unsigned char)*p << shift;
+	p++;
+	return value;
+}
+
+//************************************************************************
+// Method Name: writeKey
+//
+// Private
+//
+// Purpose: Appends a word, whole if it starts a new block, otherwise as
+//          (shared prefix, suffix) against the word before it.
+//
+// Arguments: word
+//
+// Returns: void
+//*************************************************************************
+
+void FrontCodedDict::writeKey(const string &word)
+{
+	if (words == 0 || inBlock == blockSize)
+	{
+		blockStart.push_back(data.size());
+		putVarint(data, word.length());
+		data.insert(data.end(), word.begin(), word.end());
+		inBlock = 1;
+	}
+	else
+	{
+		size_t shared = 0;
+		size_t limit = min(previous.length(), word.length());
+
+		while (shared < limit && previous[shared] == word[shared])
+			shared++;
+
+		putVarint(data, shared);
+		putVarint(data, word.length() - shared);
+		data.insert(data.end(), word.begin() + shared, word.end());
+		inBlock++;
+	}
+
+	previous = word;
+	words++;
+}
+
+//************************************************************************
+// Method Name: add
+//
+// Public
+//
+// Purpose: Adds the next word of a sorted sequence. Its count is written
+//          once the next different word (or finish) shows up, so repeats
+//          of the same word collapse into one entry.
+//
+// Arguments: word, number of occurrences
+//
+// Returns: void
+//*************************************************************************
+
+void FrontCodedDict::add(const string &word, int count)
+{
+	if (pending && word == previous)
+	{
+		pendingCount += count;
+		return;
+	}
+
+	if (pending)
+		putVarint(data, pendingCount);
+
+	writeKey(word);
+	pendingCount = count;
+	pending = true;
+}
+
+//************************************************************************
+// Method Name: finish
+//
+// Public
+//
+// Purpose: Writes the count of the last word and trims spare capacity.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void FrontCodedDict::finish()
+{
+	if (pending)
+		putVarint(data, pendingCount);
+
+	pending = false;
+	data.shrink_to_fit();
+	blockStart.shrink_to_fit();
+}
+
+//************************************************************************
+// Method Name: compareHead
+//
+// Private
+//
+// Purpose: Compares the (uncompressed) first word of a block with key.
+//
+// Arguments: block number, key
+//
+// Returns: <0, 0, >0 like string::compare
+//*************************************************************************
+
+int FrontCodedDict::compareHead(size_t block, const string &key)
+{
+	const char *p = data.data() + blockStart[block];
+	size_t length = (size_t)getVarint(p);
+	size_t common = min(length, key.length());
+	int result = memcmp(p, key.data(), common);
+
+	if (result != 0)
+		return result;
+	if (length == key.length())
+		return 0;
+	return length < key.length() ? -1 : 1;
+}
+
+//************************************************************************
+// Method Name: findWord
+//
+// Private
+//
+// Purpose: Binary search over the block heads for the last head <= key,
+//          then decodes that block until the key is found or passed.
+//
+// Arguments: key, comparison counter, set to the word's count if found
+//
+// Returns: true if found
+//*************************************************************************
+
+bool FrontCodedDict::findWord(const string &key, int &comparisons, int &count)
+{
+	long long low = 0;
+	long long high = (long long)blockStart.size() - 1;
+	long long block = -1;
+
+	while (low <= high)
+	{
+		long long mid = low + (high - low) / 2;
+		int result = compareHead((size_t)mid, key);
+
+		comparisons++;
+		if (result == 0)
+		{
+			const char *p = data.data() + blockStart[mid];
+			p += getVarint(p);
+			count = (int)getVarint(p);
+			return true;
+		}
+		else if (result < 0)
+		{
+			block = mid;
+			low = mid + 1;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+
+	if (block < 0)
+		return false;
+
+	const char *p = data.data() + blockStart[block];
+	const char *end = data.data() + ((size_t)block + 1 < blockStart.size() ? blockStart[block + 1] : data.size());
+	string current;
+
+	size_t length = (size_t)getVarint(p);
+	current.assign(p, length);
+	p += length;
+	getVarint(p);
+
+	while (p < end)
+	{
+		size_t shared = (size_t)getVarint(p);
+		size_t suffix = (size_t)getVarint(p);
+
+		current.resize(shared);
+		current.append(p, suffix);
+		p += suffix;
+		int wordCount = (int)getVarint(p);
+
+		int result = current.compare(key);
+		comparisons++;
+		if (result == 0)
+		{
+			count = wordCount;
+			return true;
+		}
+		if (result > 0)
+			break;
+	}
+	return false;
+}
+
+//************************************************************************
+// Method Name: Search
+//
+// Public
+//
+// Purpose: Looks up a word.
+//
+// Arguments: word to look for
+//
+// Returns: number of comparisons if found, 0 otherwise
+//*************************************************************************
+
+int FrontCodedDict::Search(string word)
+{
+	int comparisons = 0;
+	int count = 0;
+
+	if (findWord(word, comparisons, count))
+		return comparisons;
+	return 0;
+}
+
+//************************************************************************
+// Method Name: frequency
+//
+// Public
+//
+// Purpose: Number of times a word was in the source tree.
+//
+// Arguments: word
+//
+// Returns: its count, 0 if not present
+//*************************************************************************
+
+int FrontCodedDict::frequency(string word)
+{
+	int comparisons = 0;
+	int count = 0;
+
+	findWord(word, comparisons, count);
+	return count;
+}
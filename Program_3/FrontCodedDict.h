@@ -0,0 +1,72 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+//************************************************************************
+// FrontCodedDict - read-only compressed dictionary of sorted words.
+//
+// Words are cut into blocks of `blockSize`. The first word of a block is
+// stored whole; every other word is stored as
+//
+//     varint shared prefix length with the previous word
+//     varint suffix length
+//     suffix bytes
+//
+// and each word is followed by its count as a varint. A sorted English
+// word list shares long prefixes, so this is a fraction of the space of
+// a tree node per word.
+//
+// blockStart samples the data at every block head; Search binary searches
+// the heads (stored whole, so no decoding is needed) and then decodes at
+// most one block. Search returns the number of key comparisons like
+// AVLTree::Search (0 = not found).
+//
+// Build it from any tree with inorderWalk (AVLTree, BSTree), or by
+// calling add() with words in sorted order and then finish(). Duplicate
+// words next to each other are folded into one entry with their counts
+// added.
+//************************************************************************
+
+class FrontCodedDict {
+
+private:
+	int blockSize;
+	vector<char> data;
+	vector<uint64_t> blockStart;
+	long long words;
+
+	// builder state
+	string previous;
+	int inBlock;
+	int pendingCount;
+	bool pending;
+
+	void writeKey(const string &);
+	static void putVarint(vector<char> &, uint64_t);
+	static uint64_t getVarint(const char *&);
+	int compareHead(size_t, const string &);
+	bool findWord(const string &, int &, int &);
+
+public:
+	FrontCodedDict(int wordsPerBlock = 16);
+
+	void clear();
+	void add(const string &, int = 1);
+	void finish();
+
+	template <class Tree>
+	void build(Tree &T)
+	{
+		clear();
+		T.inorderWalk([this](const string &word, int count) { add(word, count); });
+		finish();
+	}
+
+	int Search(string);
+	int frequency(string);
+	long long size() const { return words; };
+	size_t bytes() const { return data.size() + blockStart.size() * sizeof(uint64_t); };
+};
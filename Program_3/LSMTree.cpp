@@ -0,0 +1,408 @@
+#include <algorithm>
+#include <queue>
+#include <string>
+#include <vector>
+#include "LSMTree.h"
+
+using namespace std;
+
+LSMTree::LSMTree(size_t bufferSize, int mergeFanout)
+{
+	bufferLimit = bufferSize > 0 ? bufferSize : 1;
+	fanout = mergeFanout > 1 ? mergeFanout : 2;
+	stopping = false;
+	merging = false;
+	lookups = 0;
+	probes = 0;
+	merges = 0;
+	buffer.reserve(bufferLimit);
+	runs = RunList(new vector<RunPtr>());
+
+	merger = thread(&LSMTree::mergeLoop, this);
+}
+
+LSMTree::~LSMTree()
+{
+	{
+		lock_guard<mutex> lock(runLock);
+		stopping = true;
+	}
+	mergeWanted.notify_all();
+	merger.join();
+}
+
+//************************************************************************
+// Method Name: insert
+//
+// Public
+//
+// Purpose: Adds a word to the buffer (or bumps its count there). Sorts
+//          the buffer out into a new run once it is full.
+//
+// Arguments: word, how many times to add it
+//
+// Returns: void
+//*************************************************************************
+
+void LSMTree::insert(string word, int times)
+{
+	buffer[word] += times;
+
+	if (buffer.size() >= bufferLimit)
+		flush();
+}
+
+//************************************************************************
+// Method Name: flush
+//
+// Private
+//
+// Purpose: Turns the buffer into a sorted run, appends it as the newest
+//          run and wakes the merge thread.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void LSMTree::flush()
+{
+	if (buffer.empty())
+		return;
+
+	shared_ptr<Run> run(new Run);
+	run->level = 0;
+	run->entries.reserve(buffer.size());
+	for (unordered_map<string, int>::iterator it = buffer.begin(); it != buffer.end(); ++it)
+	{
+		run->entries.push_back(make_pair(it->first, it->second));
+	}
+	sort(run->entries.begin(), run->entries.end());
+	buffer.clear();
+
+	{
+		lock_guard<mutex> lock(runLock);
+		vector<RunPtr> next(*runs);
+		next.push_back(run);
+		publish(next);
+	}
+	mergeWanted.notify_one();
+}
+
+//************************************************************************
+// Method Name: pickMerge
+//
+// Private
+//
+// Purpose: Looks for `fanout` neighbouring runs on the same level, oldest
+//          first. Caller holds runLock.
+//
+// Arguments: set to the first run and number of runs to merge
+//
+// Returns: true if there is something to merge
+//*************************************************************************
+
+bool LSMTree::pickMerge(size_t &first, size_t &count)
+{
+	const vector<RunPtr> &current = *runs;
+	size_t start = 0;
+
+	for (size_t i = 1; i <= current.size(); i++)
+	{
+		if (i == current.size() || current[i]->level != current[start]->level)
+		{
+			if (i - start >= (size_t)fanout)
+			{
+				first = start;
+				count = fanout;
+				return true;
+			}
+			start = i;
+		}
+	}
+	return false;
+}
+
+//************************************************************************
+// Method Name: mergeLoop
+//
+// Private
+//
+// Purpose: Body of the merge thread. Picks a group under the lock, merges
+//          it without the lock, then swaps the result in. Runs are only
+//          ever appended by flush() while a merge is running, so the group
+//          is still at the same position when it is replaced.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void LSMTree::mergeLoop()
+{
+	unique_lock<mutex> lock(runLock);
+
+	while (true)
+	{
+		size_t first = 0;
+		size_t count = 0;
+
+		while (!stopping && !pickMerge(first, count))
+		{
+			merging = false;
+			mergeIdle.notify_all();
+			mergeWanted.wait(lock);
+		}
+		if (stopping)
+			break;
+
+		merging = true;
+		vector<RunPtr> group(runs->begin() + first, runs->begin() + first + count);
+		int level = group[0]->level + 1;
+
+		lock.unlock();
+		RunPtr merged = mergeRuns(group, level);
+		lock.lock();
+
+		vector<RunPtr> next(*runs);
+		next.erase(next.begin() + first, next.begin() + first + count);
+		next.insert(next.begin() + first, merged);
+		publish(next);
+		merges++;
+	}
+
+	merging = false;
+	mergeIdle.notify_all();
+}
+
+//************************************************************************
+// Method Name: mergeRuns
+//
+// Private
+//
+// Purpose: k-way merge of sorted runs with a min-heap of cursors. Equal
+//          keys from different runs are combined by adding their counts.
+//
+// Arguments: runs to merge, level of the result
+//
+// Returns: the merged run
+//*************************************************************************
+
+LSMTree::RunPtr LSMTree::mergeRuns(const vector<RunPtr> &group, int level)
+{
+	typedef pair<const string *, size_t> Cursor;   // (key, run index)
+
+	struct Later {
+		bool operator()(const Cursor &a, const Cursor &b) const { return *a.first > *b.first; }
+	};
+
+	shared_ptr<Run> out(new Run);
+	priority_queue<Cursor, vector<Cursor>, Later> heap;
+	vector<size_t> position(group.size(), 0);
+	size_t total = 0;
+
+	for (size_t r = 0; r < group.size(); r++)
+	{
+		total += group[r]->entries.size();
+		if (!group[r]->entries.empty())
+			heap.push(Cursor(&group[r]->entries[0].first, r));
+	}
+
+	out->level = level;
+	out->entries.reserve(total);
+
+	while (!heap.empty())
+	{
+		size_t r = heap.top().second;
+		heap.pop();
+
+		const pair<string, int> &entry = group[r]->entries[position[r]];
+		if (!out->entries.empty() && out->entries.back().first == entry.first)
+			out->entries.back().second += entry.second;
+		else
+			out->entries.push_back(entry);
+
+		if (++position[r] < group[r]->entries.size())
+			heap.push(Cursor(&group[r]->entries[position[r]].first, r));
+	}
+
+	return out;
+}
+
+//************************************************************************
+// Method Name: findInRun
+//
+// Private
+//
+// Purpose: Binary search of one run.
+//
+// Arguments: run, key, comparison counter to add to
+//
+// Returns: index of the key in the run, -1 if it isn't there
+//*************************************************************************
+
+int LSMTree::findInRun(const Run &run, const string &key, int &comparisons)
+{
+	int low = 0;
+	int high = (int)run.entries.size() - 1;
+
+	while (low <= high)
+	{
+		int mid = low + (high - low) / 2;
+		int result = run.entries[mid].first.compare(key);
+
+		comparisons++;
+		if (result == 0)
+			return mid;
+		else if (result < 0)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
+	return -1;
+}
+
+//************************************************************************
+// Method Name: snapshot
+//
+// Private
+//
+// Purpose: The current run list. The list is never changed in place:
+//          flush, merges and compact build a new one and publish() it,
+//          so a reader just takes a reference to whichever list is
+//          current (one atomic load, no lock, no copy) and can keep
+//          reading it while the merge thread swaps in the next.
+//
+// Arguments: none
+//
+// Returns: runs, oldest first
+//*************************************************************************
+
+LSMTree::RunList LSMTree::snapshot() const
+{
+	return atomic_load(&runs);
+}
+
+//************************************************************************
+// Method Name: publish
+//
+// Private
+//
+// Purpose: Makes a new run list current. Caller holds runLock, so the
+//          writers (flush, the merge thread, compact) take turns, and
+//          they may read runs directly.
+//
+// Arguments: the new list, oldest first
+//
+// Returns: void
+//*************************************************************************
+
+void LSMTree::publish(const vector<RunPtr> &next)
+{
+	atomic_store(&runs, RunList(new vector<RunPtr>(next)));
+}
+
+//************************************************************************
+// Method Name: Search
+//
+// Public
+//
+// Purpose: Looks for a word in the buffer (one hash probe, counted as one
+//          comparison) and then in each run, newest first.
+//
+// Arguments: word to look for
+//
+// Returns: number of comparisons if found, 0 otherwise
+//*************************************************************************
+
+int LSMTree::Search(string word)
+{
+	int comparisons = 1;
+
+	lookups++;
+	probes++;
+	if (buffer.find(word) != buffer.end())
+		return comparisons;
+
+	RunList current = snapshot();
+	for (size_t i = current->size(); i-- > 0;)
+	{
+		probes++;
+		if (findInRun(*(*current)[i], word, comparisons) >= 0)
+			return comparisons;
+	}
+	return 0;
+}
+
+//************************************************************************
+// Method Name: frequency
+//
+// Public
+//
+// Purpose: Total count of a word across the buffer and every run.
+//
+// Arguments: word
+//
+// Returns: number of times it was inserted
+//*************************************************************************
+
+int LSMTree::frequency(string word)
+{
+	int total = 0;
+	int comparisons = 0;
+
+	unordered_map<string, int>::iterator it = buffer.find(word);
+	if (it != buffer.end())
+		total += it->second;
+
+	RunList current = snapshot();
+	for (size_t i = 0; i < current->size(); i++)
+	{
+		const Run &run = *(*current)[i];
+		int index = findInRun(run, word, comparisons);
+		if (index >= 0)
+			total += run.entries[index].second;
+	}
+	return total;
+}
+
+//************************************************************************
+// Method Name: compact
+//
+// Public
+//
+// Purpose: Flushes the buffer, waits for background merges to finish and
+//          merges whatever is left into a single run, so later lookups
+//          probe only one run.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void LSMTree::compact()
+{
+	flush();
+
+	unique_lock<mutex> lock(runLock);
+	size_t first = 0;
+	size_t count = 0;
+
+	mergeIdle.wait(lock, [&]() { return !merging && !pickMerge(first, count); });
+
+	if (runs->size() > 1)
+	{
+		int level = 0;
+		for (size_t i = 0; i < runs->size(); i++)
+		{
+			level = max(level, (*runs)[i]->level + 1);
+		}
+		publish(vector<RunPtr>(1, mergeRuns(*runs, level)));
+		merges++;
+	}
+}
+
+size_t LSMTree::runCount() const
+{
+	return snapshot()->size();
+}
@@ -0,0 +1,86 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <atomic>
+
+using namespace std;
+
+//************************************************************************
+// LSMTree - write-optimized dictionary in the style of a log-structured
+// merge tree, for insert-heavy workloads.
+//
+// Inserts go into an in-memory hash buffer (no tree walk at all). When
+// the buffer fills it is sorted into an immutable run. A background
+// thread merges runs so lookups don't have to check too many: whenever
+// `fanout` neighbouring runs have the same level they are merged into one
+// run a level up (size-tiered compaction).
+//
+// Search checks the buffer, then the runs newest to oldest with a binary
+// search each, and returns the number of key comparisons like
+// AVLTree::Search (0 = not found). readAmplification() is the average
+// number of places (buffer + runs) a lookup had to probe.
+//
+// Repeated words are counted like the trees' counted mode; a word's
+// count may be split across runs until they are merged, frequency()
+// adds them up.
+//
+// Like the trees, insert/Search are meant to be called from one thread;
+// the merge thread is internal.
+//************************************************************************
+
+class LSMTree {
+
+private:
+	struct Run {
+		vector<pair<string, int> > entries;   // sorted by key, unique keys
+		int level;
+	};
+	typedef shared_ptr<const Run> RunPtr;
+	typedef shared_ptr<const vector<RunPtr> > RunList;
+
+	unordered_map<string, int> buffer;
+	size_t bufferLimit;
+	int fanout;
+
+	RunList runs;                              // oldest first, never changed
+	                                           // in place: see snapshot()
+	mutex runLock;
+	condition_variable mergeWanted;
+	condition_variable mergeIdle;
+	bool stopping;
+	bool merging;
+	thread merger;
+
+	long long lookups;
+	long long probes;
+	atomic<long long> merges;
+
+	void flush();
+	bool pickMerge(size_t &, size_t &);
+	void mergeLoop();
+	static RunPtr mergeRuns(const vector<RunPtr> &, int);
+	static int findInRun(const Run &, const string &, int &);
+	RunList snapshot() const;
+	void publish(const vector<RunPtr> &);
+
+	LSMTree(const LSMTree &);
+	LSMTree &operator=(const LSMTree &);
+
+public:
+	LSMTree(size_t bufferSize = 1 << 16, int mergeFanout = 4);
+	~LSMTree();
+
+	void insert(string, int = 1);
+	int Search(string);
+	int frequency(string);
+	void compact();
+
+	size_t runCount() const;
+	long long mergeCount() const { return merges.load(); };
+	double readAmplification() const { return lookups ? (double)probes / lookups : 0.0; };
+};
@@ -0,0 +1,331 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "LearnedIndex.h"
+
+using namespace std;
+
+static const int RADIX_BITS = 12;
+
+LearnedIndex::LearnedIndex(int error)
+{
+	maxError = error > 0 ? error : 1;
+	clear();
+}
+
+//************************************************************************
+// Method Name: clear
+//
+// Public
+//
+// Purpose: Empties the index so it can be built again.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void LearnedIndex::clear()
+{
+	keys.clear();
+	keyStart.assign(1, 0);
+	prefix.clear();
+	spline.clear();
+	radix.clear();
+	shift = 0;
+	minKey = maxKey = 0;
+	errorLow = 1;
+	errorHigh = 0;
+}
+
+//************************************************************************
+// Method Name: prefixKey
+//
+// Private
+//
+// Purpose: First 8 bytes of a word as a big endian integer, zero padded,
+//          so comparing keys orders words the way string compare does
+//          (words that share 8 bytes get equal keys).
+//
+// Arguments: word bytes, length
+//
+// Returns: the key
+//*************************************************************************
+
+uint64_t LearnedIndex::prefixKey(const char *word, size_t length)
+{
+	uint64_t key = 0;
+
+	for (size_t i = 0; i < 8; i++)
+	{
+		key <<= 8;
+		if (i < length)
+			key |= (unsigned char)word[i];
+	}
+	return key;
+}
+
+//************************************************************************
+// Method Name: add
+//
+// Public
+//
+// Purpose: Appends the next word of a sorted sequence, skipping repeats.
+//
+// Arguments: word
+//
+// Returns: void
+//*************************************************************************
+
+void LearnedIndex::add(const string &word)
+{
+	size_t n = size();
+
+	if (n > 0 && word.length() == keyStart[n] - keyStart[n - 1] &&
+		keys.compare(keyStart[n - 1], word.length(), word) == 0)
+		return;
+
+	keys += word;
+	keyStart.push_back((uint32_t)keys.length());
+	prefix.push_back(prefixKey(word.data(), word.length()));
+}
+
+//************************************************************************
+// Method Name: buildSpline
+//
+// Private
+//
+// Purpose: Greedy spline corridor. Starting from a knot, keeps the range
+//          of slopes that pass within maxError of every word seen since;
+//          when the next word's slope falls outside it, the word before
+//          becomes a knot and a new corridor starts there. Words sharing
+//          a key are fitted at the first one's position.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void LearnedIndex::buildSpline()
+{
+	size_t n = size();
+	Knot base = { prefix[0], 0 };
+	Knot last = base;
+	double upper = 0.0;
+	double lower = 0.0;
+	bool open = false;
+
+	spline.assign(1, base);
+
+	for (size_t i = 1; i < n; i++)
+	{
+		if (prefix[i] == prefix[i - 1])
+			continue;
+
+		Knot point = { prefix[i], (uint32_t)i };
+		double dx = (double)(point.key - base.key);
+		double dy = (double)point.position - base.position;
+
+		if (open && (dy / dx > upper || dy / dx < lower))
+		{
+			spline.push_back(last);
+			base = last;
+			open = false;
+			dx = (double)(point.key - base.key);
+			dy = (double)point.position - base.position;
+		}
+
+		if (!open)
+		{
+			upper = (dy + maxError) / dx;
+			lower = (dy - maxError) / dx;
+			open = true;
+		}
+		else
+		{
+			upper = min(upper, (dy + maxError) / dx);
+			lower = max(lower, (dy - maxError) / dx);
+		}
+		last = point;
+	}
+
+	if (last.key != base.key)
+		spline.push_back(last);
+}
+
+//************************************************************************
+// Method Name: buildRadix
+//
+// Private
+//
+// Purpose: Fills the radix table over the top RADIX_BITS bits of
+//          (key - minKey), so predict only has to search the few knots
+//          that share a key's top bits.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void LearnedIndex::buildRadix()
+{
+	uint64_t range = maxKey - minKey;
+	size_t knot = 0;
+
+	shift = 0;
+	while ((range >> shift) >= ((uint64_t)1 << RADIX_BITS))
+		shift++;
+
+	radix.assign((size_t)(range >> shift) + 2, 0);
+	for (size_t b = 0; b < radix.size(); b++)
+	{
+		while (knot < spline.size() && ((spline[knot].key - minKey) >> shift) < b)
+			knot++;
+		radix[b] = (uint32_t)knot;
+	}
+}
+
+//************************************************************************
+// Method Name: predict
+//
+// Private
+//
+// Purpose: Evaluates the model: finds the last knot at or below the key
+//          (radix table, then a binary search on the integer keys of a
+//          handful of knots) and interpolates to the next one.
+//
+// Arguments: key, between minKey and maxKey
+//
+// Returns: estimated position of the key in the sorted array
+//*************************************************************************
+
+double LearnedIndex::predict(uint64_t key) const
+{
+	size_t b = (size_t)((key - minKey) >> shift);
+	size_t first = radix[b] > 0 ? radix[b] - 1 : 0;
+	size_t last = radix[b + 1];
+	size_t j = upper_bound(spline.begin() + first, spline.begin() + last, key,
+		[](uint64_t k, const Knot &knot) { return k < knot.key; }) - spline.begin() - 1;
+
+	if (j + 1 >= spline.size())
+		return spline[j].position;
+
+	const Knot &left = spline[j];
+	const Knot &right = spline[j + 1];
+
+	return left.position + (double)(key - left.key) * ((double)right.position - left.position) / (double)(right.key - left.key);
+}
+
+//************************************************************************
+// Method Name: finish
+//
+// Public
+//
+// Purpose: Trains the index on the added words, then runs every word
+//          through the finished model to record the worst errors either
+//          way, so the Search window is exact rather than estimated.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void LearnedIndex::finish()
+{
+	size_t n = size();
+
+	spline.clear();
+	radix.clear();
+	errorLow = 1;
+	errorHigh = 0;
+	if (n == 0)
+		return;
+
+	minKey = prefix[0];
+	maxKey = prefix[n - 1];
+	buildSpline();
+	buildRadix();
+
+	errorLow = errorHigh = 0;
+	for (size_t i = 0; i < n; i++)
+	{
+		long long error = (long long)i - (long long)floor(predict(prefix[i]));
+
+		errorLow = (int32_t)min<long long>(errorLow, error);
+		errorHigh = (int32_t)max<long long>(errorHigh, error);
+	}
+
+	prefix.clear();
+	prefix.shrink_to_fit();
+}
+
+//************************************************************************
+// Method Name: compareAt
+//
+// Private
+//
+// Purpose: Compares the word at a position in the sorted array with a word.
+//
+// Arguments: position, word
+//
+// Returns: <0, 0, >0 like string::compare
+//*************************************************************************
+
+int LearnedIndex::compareAt(size_t i, const string &word) const
+{
+	size_t length = keyStart[i + 1] - keyStart[i];
+	int result = memcmp(keys.data() + keyStart[i], word.data(), min(length, word.length()));
+
+	if (result != 0)
+		return result;
+	if (length == word.length())
+		return 0;
+	return length < word.length() ? -1 : 1;
+}
+
+//************************************************************************
+// Method Name: Search
+//
+// Public
+//
+// Purpose: Predicts where the word would be and binary searches the
+//          error window around that position. A word whose key is outside
+//          the stored range can't be there and costs no compares.
+//
+// Arguments: word to look for
+//
+// Returns: number of comparisons if found, 0 otherwise
+//*************************************************************************
+
+int LearnedIndex::Search(string word)
+{
+	if (spline.empty())
+		return 0;
+
+	uint64_t key = prefixKey(word.data(), word.length());
+
+	if (key < minKey || key > maxKey)
+		return 0;
+
+	long long guess = (long long)floor(predict(key));
+	long long low = max<long long>(0, guess + errorLow);
+	long long high = min<long long>((long long)size() - 1, guess + errorHigh);
+	int count = 0;
+
+	while (low <= high)
+	{
+		long long mid = low + (high - low) / 2;
+		int result = compareAt((size_t)mid, word);
+
+		count++;
+		if (result == 0)
+			return count;
+		else if (result < 0)
+			low = mid + 1;
+		else
+			high = mid - 1;
+	}
+	return 0;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+//************************************************************************
+// LearnedIndex - experimental read-only word set that replaces the search
+// tree with a model of the key distribution (a radix spline).
+//
+// Every word is turned into a number, its first 8 bytes read big endian,
+// so numeric order is word order. The words sit in one sorted array and
+// the model learns position = f(number):
+//
+//     spline   a few knots (number, position) picked at build time so
+//              that straight lines between neighbouring knots are never
+//              more than maxError positions off for any word
+//     radix    a table on the top bits of the number saying which knots
+//              to look between, so finding the segment is a table read
+//              and a short integer search
+//
+// Search predicts a position and binary searches only the window
+// [prediction + errorLow, prediction + errorHigh], which is guaranteed to
+// hold the word if it is present (words sharing their first 8 bytes widen
+// it a little). Only those string compares are counted, so Search returns
+// comparisons like AVLTree::Search (0 = not found).
+//
+// Build it from a tree with build() (inorderWalk), or add() words in
+// sorted order and call finish(). Repeated words are stored once.
+//************************************************************************
+
+class LearnedIndex {
+
+private:
+	struct Knot {
+		uint64_t key;
+		uint32_t position;
+	};
+
+	int maxError;
+	string keys;
+	vector<uint32_t> keyStart;  // keyStart[i] .. keyStart[i + 1] is word i
+	vector<uint64_t> prefix;    // builder state, the key of each word
+	vector<Knot> spline;
+	vector<uint32_t> radix;     // radix[b] = first knot whose top bits are >= b
+	int shift;
+	uint64_t minKey;
+	uint64_t maxKey;
+	int32_t errorLow;           // prediction + errorLow <= true position
+	int32_t errorHigh;          // prediction + errorHigh >= true position
+
+	static uint64_t prefixKey(const char *, size_t);
+	void buildSpline();
+	void buildRadix();
+	double predict(uint64_t) const;
+	int compareAt(size_t, const string &) const;
+
+public:
+	LearnedIndex(int maxError = 16);
+
+	void clear();
+	void add(const string &);
+	void finish();
+
+	template <class Tree>
+	void build(Tree &T)
+	{
+		clear();
+		T.inorderWalk([this](const string &word, int) { add(word); });
+		finish();
+	}
+
+	int Search(string);
+	size_t size() const { return keyStart.empty() ? 0 : keyStart.size() - 1; };
+	size_t bytes() const { return keys.size() + keyStart.size() * sizeof(uint32_t) + spline.size() * sizeof(Knot) + radix.size() * sizeof(uint32_t); };
+	size_t knotCount() const { return spline.size(); };
+	int window() const { return errorHigh - errorLow + 1; };
+};
@@ -0,0 +1,139 @@
+#include <string>
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+MappedFile::MappedFile()
+{
+	base = NULL;
+	length = 0;
+	isOpen = false;
+#ifdef _WIN32
+	fileHandle = INVALID_HANDLE_VALUE;
+	mapHandle = NULL;
+#else
+	fd = -1;
+#endif
+}
+
+MappedFile::MappedFile(string filename) : MappedFile()
+{
+	open(filename);
+}
+
+MappedFile::~MappedFile()
+{
+	close();
+}
+
+//************************************************************************
+// Method Name: open
+//
+// Public
+//
+// Purpose: Maps the named file into memory read-only. An empty file opens
+//          fine but has a NULL data() and a size() of 0.
+//
+// Arguments: name of the file to map
+//
+// Returns: true if the file could be mapped
+//*************************************************************************
+
+bool MappedFile::open(string filename)
+{
+	close();
+
+#ifdef _WIN32
+	fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+		OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (fileHandle == INVALID_HANDLE_VALUE)
+		return false;
+
+	LARGE_INTEGER fileSize;
+	GetFileSizeEx(fileHandle, &fileSize);
+	length = (size_t)fileSize.QuadPart;
+
+	if (length > 0)
+	{
+		mapHandle = CreateFileMappingA(fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+		if (mapHandle)
+			base = (const char *)MapViewOfFile(mapHandle, FILE_MAP_READ, 0, 0, 0);
+		if (!base)
+		{
+			close();
+			return false;
+		}
+	}
+#else
+	fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+		return false;
+
+	struct stat info;
+	if (fstat(fd, &info) != 0)
+	{
+		close();
+		return false;
+	}
+	length = (size_t)info.st_size;
+
+	if (length > 0)
+	{
+		void *p = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (p == MAP_FAILED)
+		{
+			close();
+			return false;
+		}
+		base = (const char *)p;
+		madvise(p, length, MADV_SEQUENTIAL);
+	}
+#endif
+
+	isOpen = true;
+	return true;
+}
+
+//************************************************************************
+// Method Name: close
+//
+// Public
+//
+// Purpose: Unmaps the file. Safe to call more than once.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+	if (base)
+		UnmapViewOfFile(base);
+	if (mapHandle)
+		CloseHandle(mapHandle);
+	if (fileHandle != INVALID_HANDLE_VALUE)
+		CloseHandle(fileHandle);
+	mapHandle = NULL;
+	fileHandle = INVALID_HANDLE_VALUE;
+#else
+	if (base)
+		munmap((void *)base, length);
+	if (fd >= 0)
+		::close(fd);
+	fd = -1;
+#endif
+	base = NULL;
+	length = 0;
+	isOpen = false;
+}
@@ -0,0 +1,41 @@
+#pragma once
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+//************************************************************************
+// MappedFile - maps a whole file read-only into memory so it can be
+// scanned in place without copying it through iostreams.
+//
+// Anything pointing into data() is only valid while the MappedFile is
+// open, so keep it alive for as long as those pointers are used.
+//************************************************************************
+
+class MappedFile {
+
+private:
+	const char *base;
+	size_t length;
+	bool isOpen;
+#ifdef _WIN32
+	void *fileHandle;
+	void *mapHandle;
+#else
+	int fd;
+#endif
+
+	MappedFile(const MappedFile &);
+	MappedFile &operator=(const MappedFile &);
+
+public:
+	MappedFile();
+	MappedFile(string filename);
+	~MappedFile();
+
+	bool open(string);
+	void close();
+	bool good() const { return isOpen; };
+	const char *data() const { return base; };
+	size_t size() const { return length; };
+};
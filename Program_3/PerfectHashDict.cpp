@@ -0,0 +1,305 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "PerfectHashDict.h"
+
+using namespace std;
+
+static const uint32_t HASH_VERSION = 2;
+static const uint32_t MAX_PILOT = 1u << 24;
+
+PerfectHashDict::PerfectHashDict()
+{
+	header = NULL;
+	pilot = NULL;
+	keyStart = NULL;
+	keys = NULL;
+}
+
+//************************************************************************
+// Method Name: mix, hashWord
+//
+// Private
+//
+// Purpose: 64-bit hashing. mix is the splitmix64 finalizer; hashWord is
+//          FNV-1a over the bytes, started from the seed and finished with
+//          mix so every bit of the result depends on every input byte.
+//
+//*************************************************************************
+
+uint64_t PerfectHashDict::mix(uint64_t x)
+{
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ULL;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBULL;
+	x ^= x >> 31;
+	return x;
+}
+
+uint64_t PerfectHashDict::hashWord(const char *word, size_t length, uint64_t seed)
+{
+	uint64_t h = 0xCBF29CE484222325ULL ^ seed;
+
+	for (size_t i = 0; i < length; i++)
+	{
+		h ^= (unsigned char)word[i];
+		h *= 0x100000001B3ULL;
+	}
+	return mix(h);
+}
+
+static uint64_t align8(uint64_t n)
+{
+	return (n + 7) & ~(uint64_t)7;
+}
+
+//************************************************************************
+// Method Name: build
+//
+// Public (static)
+//
+// Purpose: Builds the perfect hash for a word list and writes the table
+//          file. Buckets are placed biggest first while the table is still
+//          empty; for each one pilots 0, 1, 2, ... are tried until all of
+//          its words fall into distinct free slots. If some bucket can't
+//          be placed the whole thing is retried with another seed.
+//
+// Arguments: words (duplicates are fine), name of the file to write,
+//            hashFiles() of the files the words came from (0 = none)
+//
+// Returns: false if the file could not be written
+//*************************************************************************
+
+bool PerfectHashDict::build(const vector<string> &wordList, string filename, uint64_t source)
+{
+	vector<string> words(wordList);
+	sort(words.begin(), words.end());
+	words.erase(unique(words.begin(), words.end()), words.end());
+
+	uint32_t n = (uint32_t)words.size();
+	uint32_t buckets = max(1u, n / 4);
+	vector<uint32_t> pilots(buckets, 0);
+	vector<uint32_t> slotWord(n, 0);
+	uint64_t seed = 0;
+
+	for (bool placed = (n == 0); !placed; seed++)
+	{
+		vector<uint64_t> h2(n);
+		vector<vector<uint32_t> > bucketWords(buckets);
+		vector<bool> taken(n, false);
+
+		for (uint32_t w = 0; w < n; w++)
+		{
+			uint64_t h = hashWord(words[w].data(), words[w].length(), seed);
+			h2[w] = mix(h ^ 0x9E3779B97F4A7C15ULL);
+			bucketWords[h % buckets].push_back(w);
+		}
+
+		vector<uint32_t> order(buckets);
+		for (uint32_t b = 0; b < buckets; b++)
+			order[b] = b;
+		stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b)
+		{
+			return bucketWords[a].size() > bucketWords[b].size();
+		});
+
+		placed = true;
+		for (uint32_t i = 0; i < buckets && placed; i++)
+		{
+			const vector<uint32_t> &members = bucketWords[order[i]];
+			vector<uint32_t> slots(members.size());
+			bool fits = members.empty();
+			uint32_t p = 0;
+
+			for (; !fits && p < MAX_PILOT; p++)
+			{
+				fits = true;
+				for (size_t m = 0; m < members.size() && fits; m++)
+				{
+					slots[m] = (uint32_t)((h2[members[m]] ^ mix(p)) % n);
+					if (taken[slots[m]])
+						fits = false;
+					for (size_t k = 0; k < m && fits; k++)
+					{
+						if (slots[k] == slots[m])
+							fits = false;
+					}
+				}
+			}
+
+			if (!fits)
+			{
+				placed = false;
+				break;
+			}
+
+			pilots[order[i]] = members.empty() ? 0 : p - 1;
+			for (size_t m = 0; m < members.size(); m++)
+			{
+				taken[slots[m]] = true;
+				slotWord[slots[m]] = members[m];
+			}
+		}
+
+		if (placed)
+			break;
+	}
+
+	Header head;
+	memset(&head, 0, sizeof(head));
+	memcpy(head.magic, "PHF1", 4);
+	head.version = HASH_VERSION;
+	head.words = n;
+	head.buckets = buckets;
+	head.seed = seed;
+	head.source = source;
+	head.pilotOffset = align8(sizeof(Header));
+	head.keyStartOffset = align8(head.pilotOffset + (uint64_t)buckets * sizeof(uint32_t));
+	head.keysOffset = align8(head.keyStartOffset + ((uint64_t)n + 1) * sizeof(uint32_t));
+
+	vector<uint32_t> starts(n + 1, 0);
+	string keyBytes;
+	for (uint32_t s = 0; s < n; s++)
+	{
+		starts[s] = (uint32_t)keyBytes.length();
+		keyBytes += words[slotWord[s]];
+	}
+	starts[n] = (uint32_t)keyBytes.length();
+	head.fileSize = head.keysOffset + keyBytes.length();
+
+	vector<char> image((size_t)head.fileSize, 0);
+	memcpy(&image[0], &head, sizeof(head));
+	memcpy(&image[(size_t)head.pilotOffset], pilots.data(), buckets * sizeof(uint32_t));
+	memcpy(&image[(size_t)head.keyStartOffset], starts.data(), starts.size() * sizeof(uint32_t));
+	if (!keyBytes.empty())
+		memcpy(&image[(size_t)head.keysOffset], keyBytes.data(), keyBytes.length());
+
+	ofstream out(filename, ios::binary);
+	out.write(image.data(), image.size());
+	return out.good();
+}
+
+//************************************************************************
+// Method Name: hashFiles
+//
+// Public (static)
+//
+// Purpose: One hash over the names, sizes and contents of a set of files,
+//          to tell whether a table is still in step with its word lists.
+//          A missing file hashes differently from an empty one.
+//
+// Arguments: file names
+//
+// Returns: the hash (never 0)
+//*************************************************************************
+
+uint64_t PerfectHashDict::hashFiles(const vector<string> &names)
+{
+	uint64_t h = 0;
+
+	for (size_t f = 0; f < names.size(); f++)
+	{
+		MappedFile in;
+		bool found = in.open(names[f]);
+		uint64_t facts[2] = { found ? (uint64_t)in.size() : ~(uint64_t)0, hashWord(in.data(), in.size(), h) };
+
+		h = hashWord(names[f].data(), names[f].length(), h);
+		h = hashWord((const char *)facts, sizeof(facts), h);
+	}
+	return h ? h : 1;
+}
+
+//************************************************************************
+// Method Name: load
+//
+// Public
+//
+// Purpose: Maps a table file written by build() and points straight into
+//          it. The header is checked so a stale or foreign file is
+//          refused, and every section is checked against the file size
+//          (and the key offsets for order) so Search never reads outside
+//          the mapping.
+//
+// Arguments: table file name, hashFiles() of the word lists it should have
+//            been built from (0 = don't check)
+//
+// Returns: true if the table is usable
+//*************************************************************************
+
+bool PerfectHashDict::load(string filename, uint64_t source)
+{
+	header = NULL;
+
+	if (!file.open(filename) || file.size() < sizeof(Header))
+	{
+		file.close();
+		return false;
+	}
+
+	const Header *h = (const Header *)file.data();
+	uint64_t size = file.size();
+
+	// [offset, offset + count * width) lies inside the file, past the
+	// header, on a 4 byte boundary
+	auto section = [&](uint64_t offset, uint64_t count, uint64_t width) {
+		return offset >= sizeof(Header) && offset % 4 == 0 && offset <= size &&
+			count <= (size - offset) / width;
+	};
+
+	bool ok = memcmp(h->magic, "PHF1", 4) == 0 && h->version == HASH_VERSION &&
+		h->fileSize == size && h->buckets != 0 && (source == 0 || h->source == source) &&
+		section(h->pilotOffset, h->buckets, sizeof(uint32_t)) &&
+		section(h->keyStartOffset, (uint64_t)h->words + 1, sizeof(uint32_t)) &&
+		section(h->keysOffset, 0, 1);
+
+	if (ok)
+	{
+		const uint32_t *starts = (const uint32_t *)(file.data() + h->keyStartOffset);
+
+		for (uint32_t s = 0; s < h->words && ok; s++)
+			ok = starts[s] <= starts[s + 1];
+		ok = ok && starts[h->words] <= size - h->keysOffset;
+	}
+
+	if (!ok)
+	{
+		file.close();
+		return false;
+	}
+
+	header = h;
+	pilot = (const uint32_t *)(file.data() + h->pilotOffset);
+	keyStart = (const uint32_t *)(file.data() + h->keyStartOffset);
+	keys = file.data() + h->keysOffset;
+	return true;
+}
+
+//************************************************************************
+// Method Name: Search
+//
+// Public
+//
+// Purpose: Exact membership test: one hash, one table read, one compare.
+//
+// Arguments: word to look for
+//
+// Returns: 1 (comparisons) if found, 0 otherwise
+//*************************************************************************
+
+int PerfectHashDict::Search(string word)
+{
+	if (!header || header->words == 0)
+		return 0;
+
+	uint64_t h = hashWord(word.data(), word.length(), header->seed);
+	uint64_t h2 = mix(h ^ 0x9E3779B97F4A7C15ULL);
+	uint32_t slot = (uint32_t)((h2 ^ mix(pilot[h % header->buckets])) % header->words);
+	uint32_t length = keyStart[slot + 1] - keyStart[slot];
+
+	if (length == word.length() && memcmp(keys + keyStart[slot], word.data(), length) == 0)
+		return 1;
+	return 0;
+}
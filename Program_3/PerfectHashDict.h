@@ -0,0 +1,76 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <cstdint>
+#include "MappedFile.h"
+
+using namespace std;
+
+//************************************************************************
+// PerfectHashDict - exact membership for a fixed word list with a minimal
+// perfect hash, for dictionaries that never change (adjectives.txt,
+// adverbs.txt, nouns.txt, verbs.txt).
+//
+// build() runs once, ahead of time, and writes a binary table file
+// (analyze_trees -genhash does this for the four word files). load()
+// just maps that file: there is nothing to parse or allocate at startup.
+//
+// The hash is hash-and-displace (CHD / PTHash style). Every word hashes
+// to a bucket; each bucket stores one small "pilot" number, chosen at
+// build time so that all of its words land in free slots. With n words
+// and n slots every word gets its own slot, so a lookup is
+//
+//     bucket = h1(word) % buckets
+//     slot   = (h2(word) ^ mix(pilot[bucket])) % n
+//
+// and a single string compare against the word stored in that slot.
+// Search returns 1 (one comparison) if the word is there, 0 if not.
+//
+// The header records a hash of the word files the table was built from
+// (hashFiles), so load() can refuse a table that is older than its lists.
+// load() checks every offset and length against the file before using
+// it, so a truncated or damaged file is refused rather than read past.
+//
+// File layout (native byte order, every section 8 byte aligned):
+//     Header
+//     uint32 pilot[buckets]
+//     uint32 keyStart[words + 1]   offsets into the key bytes, by slot
+//     char   keys[]
+//************************************************************************
+
+class PerfectHashDict {
+
+private:
+	struct Header {
+		char magic[4];
+		uint32_t version;
+		uint32_t words;
+		uint32_t buckets;
+		uint64_t seed;
+		uint64_t pilotOffset;
+		uint64_t keyStartOffset;
+		uint64_t keysOffset;
+		uint64_t fileSize;
+		uint64_t source;     // hashFiles() of the word lists it was built from
+	};
+
+	MappedFile file;
+	const Header *header;
+	const uint32_t *pilot;
+	const uint32_t *keyStart;
+	const char *keys;
+
+	static uint64_t hashWord(const char *, size_t, uint64_t);
+	static uint64_t mix(uint64_t);
+
+public:
+	PerfectHashDict();
+
+	static bool build(const vector<string> &, string, uint64_t source = 0);
+	bool load(string, uint64_t source = 0);
+	static uint64_t hashFiles(const vector<string> &);
+
+	int Search(string);
+	size_t size() const { return header ? header->words : 0; };
+	size_t bytes() const { return file.size(); };
+};
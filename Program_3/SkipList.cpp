@@ -0,0 +1,410 @@
+#include <atomic>
+#include <random>
+#include <string>
+#include <thread>
+#include "SkipList.h"
+
+using namespace std;
+
+SkipList::SLnode::SLnode(string word, int level, bool tail)
+{
+	key = word;
+	topLevel = level;
+	isTail = tail;
+	count = 1;
+	allocNext = NULL;
+	next = new atomic<uintptr_t>[level + 1];
+	for (int i = 0; i <= level; i++)
+	{
+		next[i].store(0, memory_order_relaxed);
+	}
+}
+
+SkipList::SLnode::~SLnode()
+{
+	delete[] next;
+}
+
+SkipList::SkipList()
+{
+	allocated = NULL;
+	distinct = 0;
+
+	head = new SLnode("", MAX_LEVEL - 1);
+	tail = new SLnode("", MAX_LEVEL - 1, true);
+	track(head);
+	track(tail);
+
+	for (int i = 0; i < MAX_LEVEL; i++)
+	{
+		head->next[i].store(makeLink(tail));
+	}
+}
+
+SkipList::~SkipList()
+{
+	SLnode *n = allocated.load();
+
+	while (n)
+	{
+		SLnode *next = n->allocNext;
+		delete n;
+		n = next;
+	}
+}
+
+//************************************************************************
+// Method Name: track
+//
+// Private
+//
+// Purpose: Pushes a new node on the allocation list (a lock-free stack)
+//          so the destructor can free it, linked or not.
+//
+// Arguments: new node
+//
+// Returns: void
+//*************************************************************************
+
+void SkipList::track(SLnode *n)
+{
+	SLnode *top = allocated.load();
+
+	do
+	{
+		n->allocNext = top;
+	} while (!allocated.compare_exchange_weak(top, n));
+}
+
+//************************************************************************
+// Method Name: compare
+//
+// Private
+//
+// Purpose: Three-way compare of a node's key against key. The tail
+//          sentinel is larger than every key.
+//
+// Arguments: node, key
+//
+// Returns: <0, 0, >0 like string::compare
+//*************************************************************************
+
+int SkipList::compare(SLnode *n, const string &key)
+{
+	if (n->isTail)
+		return 1;
+
+	return n->key.compare(key);
+}
+
+//************************************************************************
+// Method Name: randomLevel
+//
+// Private
+//
+// Purpose: Picks a tower height with P(level >= i) = 1/2^i, from a per
+//          thread generator so threads don't contend on it.
+//
+// Arguments: none
+//
+// Returns: top level for a new node (0 based)
+//*************************************************************************
+
+int SkipList::randomLevel()
+{
+	static thread_local mt19937 generator((unsigned)hash<thread::id>()(this_thread::get_id()));
+	uint32_t bits = generator();
+	int level = 0;
+
+	while ((bits & 1) && level < MAX_LEVEL - 1)
+	{
+		level++;
+		bits >>= 1;
+	}
+	return level;
+}
+
+//************************************************************************
+// Method Name: find
+//
+// Private
+//
+// Purpose: Fills preds/succs with the nodes on either side of key at
+//          every level, unlinking any marked nodes met on the way. If an
+//          unlink CAS fails the list changed underneath us, so start over
+//          from the head.
+//
+// Arguments: key, arrays of MAX_LEVEL predecessors and successors
+//
+// Returns: true if an unmarked node holding key is in the bottom level
+//*************************************************************************
+
+bool SkipList::find(const string &key, SLnode **preds, SLnode **succs)
+{
+retry:
+	SLnode *pred = head;
+	SLnode *curr = NULL;
+
+	for (int level = MAX_LEVEL - 1; level >= 0; level--)
+	{
+		curr = pointer(pred->next[level].load());
+
+		while (true)
+		{
+			uintptr_t link = curr->next[level].load();
+
+			while (marked(link))
+			{
+				uintptr_t expected = makeLink(curr);
+				if (!pred->next[level].compare_exchange_strong(expected, makeLink(pointer(link))))
+					goto retry;
+
+				curr = pointer(link);
+				link = curr->next[level].load();
+			}
+
+			if (compare(curr, key) < 0)
+			{
+				pred = curr;
+				curr = pointer(link);
+			}
+			else
+			{
+				break;
+			}
+		}
+		preds[level] = pred;
+		succs[level] = curr;
+	}
+
+	return compare(curr, key) == 0;
+}
+
+//************************************************************************
+// Method Name: insert
+//
+// Public
+//
+// Purpose: Adds a word, or bumps its count if it is already there.
+//
+// Arguments: word, how many times to add it
+//
+// Returns: void
+//*************************************************************************
+
+void SkipList::insert(string word, int times)
+{
+	SLnode *preds[MAX_LEVEL];
+	SLnode *succs[MAX_LEVEL];
+	int topLevel = randomLevel();
+	SLnode *newNode = NULL;
+
+	while (true)
+	{
+		if (find(word, preds, succs))
+		{
+			SLnode *found = succs[0];
+			int count = found->count.load();
+
+			while (count != DEAD && !found->count.compare_exchange_weak(count, count + times))
+			{
+			}
+			if (count != DEAD)
+			{
+				if (newNode)
+					newNode->count = 0;   // lost the race, node is never linked
+				return;
+			}
+
+			// a remove got to it first: help mark it so find() unlinks it,
+			// then go round again and link a fresh node
+			markAll(found);
+			continue;
+		}
+
+		if (!newNode)
+		{
+			newNode = new SLnode(word, topLevel);
+			newNode->count = times;
+			track(newNode);
+		}
+
+		for (int level = 0; level <= topLevel; level++)
+		{
+			newNode->next[level].store(makeLink(succs[level]));
+		}
+
+		// linking the bottom level is what makes the word visible
+		uintptr_t expected = makeLink(succs[0]);
+		if (preds[0]->next[0].compare_exchange_strong(expected, makeLink(newNode)))
+			break;
+	}
+
+	distinct++;
+
+	for (int level = 1; level <= topLevel; level++)
+	{
+		while (true)
+		{
+			// keep the new node pointing at the current successor; if it
+			// has been marked meanwhile it is being removed, so stop
+			uintptr_t link = newNode->next[level].load();
+			if (marked(link))
+				return;
+			if (pointer(link) != succs[level] &&
+				!newNode->next[level].compare_exchange_strong(link, makeLink(succs[level])))
+				return;
+
+			uintptr_t expected = makeLink(succs[level]);
+			if (preds[level]->next[level].compare_exchange_strong(expected, makeLink(newNode)))
+				break;
+
+			find(word, preds, succs);
+		}
+	}
+}
+
+//************************************************************************
+// Method Name: remove
+//
+// Public
+//
+// Purpose: Removes a word (all of its occurrences). Whoever swaps the
+//          node's count to DEAD removed the word; that is the moment it
+//          is gone, so no insert can add to it afterwards. The node is
+//          then marked and unlinked.
+//
+// Arguments: word to remove
+//
+// Returns: true if this call removed the word
+//*************************************************************************
+
+bool SkipList::remove(string word)
+{
+	SLnode *preds[MAX_LEVEL];
+	SLnode *succs[MAX_LEVEL];
+
+	if (!find(word, preds, succs))
+		return false;
+
+	SLnode *victim = succs[0];
+	int count = victim->count.load();
+
+	do
+	{
+		if (count == DEAD)
+			return false;
+	} while (!victim->count.compare_exchange_weak(count, DEAD));
+
+	distinct--;
+	markAll(victim);
+	find(word, preds, succs);
+	return true;
+}
+
+//************************************************************************
+// Method Name: markAll
+//
+// Private
+//
+// Purpose: Marks every level of a node whose count is DEAD, top-down, so
+//          traversals step over it and find() unlinks it. Both the
+//          remover and inserts that run into the node call it; marking
+//          an already marked level does nothing.
+//
+// Arguments: node being removed
+//
+// Returns: void
+//*************************************************************************
+
+void SkipList::markAll(SLnode *victim)
+{
+	for (int level = victim->topLevel; level >= 0; level--)
+	{
+		uintptr_t link = victim->next[level].load();
+		while (!marked(link))
+		{
+			victim->next[level].compare_exchange_weak(link, link | 1);
+		}
+	}
+}
+
+//************************************************************************
+// Method Name: Search
+//
+// Public
+//
+// Purpose: Wait-free lookup. Walks down the levels stepping over marked
+//          nodes without helping to unlink them.
+//
+// Arguments: word to look for
+//
+// Returns: number of key comparisons if found, 0 otherwise
+//*************************************************************************
+
+int SkipList::Search(string word)
+{
+	SLnode *pred = head;
+	SLnode *curr = NULL;
+	int count = 0;
+	int result = 1;
+
+	for (int level = MAX_LEVEL - 1; level >= 0; level--)
+	{
+		curr = pointer(pred->next[level].load());
+
+		while (true)
+		{
+			uintptr_t link = curr->next[level].load();
+
+			while (marked(link))
+			{
+				curr = pointer(link);
+				link = curr->next[level].load();
+			}
+
+			if (!curr->isTail)
+				count++;
+
+			result = compare(curr, word);
+			if (result < 0)
+			{
+				pred = curr;
+				curr = pointer(link);
+			}
+			else
+			{
+				break;
+			}
+		}
+
+		if (result == 0)
+			return curr->count.load() != DEAD ? count : 0;
+	}
+	return 0;
+}
+
+//************************************************************************
+// Method Name: frequency
+//
+// Public
+//
+// Purpose: Number of times a word was inserted.
+//
+// Arguments: word
+//
+// Returns: its count, 0 if not present
+//*************************************************************************
+
+int SkipList::frequency(string word)
+{
+	SLnode *preds[MAX_LEVEL];
+	SLnode *succs[MAX_LEVEL];
+
+	if (!find(word, preds, succs))
+		return 0;
+
+	int count = succs[0]->count.load();
+
+	return count != DEAD ? count : 0;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+using namespace std;
+
+//************************************************************************
+// SkipList - lock-free ordered dictionary for concurrent use, an
+// alternative to AVLTree when many threads insert at once.
+//
+// Follows the lock-free skip list of Herlihy & Shavit ("The Art of
+// Multiprocessor Programming", ch. 14):
+//
+//   insert  links the new node at the bottom level with a CAS (that is
+//           the moment it becomes visible) and then links the upper
+//           levels, re-finding predecessors whenever a CAS loses a race
+//   remove  swaps the node's count to DEAD (logical delete; the thread
+//           whose swap lands owns the removal), then marks its next
+//           pointers top-down and unlinks it (physical delete); other
+//           traversals also unlink marked nodes they walk past
+//   Search  never writes or retries, it just steps over marked nodes,
+//           so it is wait-free. Returns the number of key comparisons
+//           like AVLTree::Search (0 = not found).
+//
+// Marks live in the low bit of each next pointer. Repeated inserts of a
+// word bump an atomic count on its node (like the trees' counted mode)
+// with a CAS that fails once the count is DEAD; such an insert helps
+// mark the node and links a fresh one, so it is never lost to a remove.
+//
+// Unlinked nodes can't be freed while another thread may still be
+// reading them, so every node stays on an allocation list and is freed
+// when the SkipList is destroyed.
+//************************************************************************
+
+class SkipList {
+
+private:
+	static const int MAX_LEVEL = 32;
+	static const int DEAD = -1;   // count of a removed node
+
+	struct SLnode {
+		string key;
+		int topLevel;
+		bool isTail;
+		atomic<int> count;
+		atomic<uintptr_t> *next;
+		SLnode *allocNext;
+
+		SLnode(string word, int level, bool tail = false);
+		~SLnode();
+	};
+
+	SLnode *head;
+	SLnode *tail;
+	atomic<SLnode *> allocated;
+	atomic<long long> distinct;
+
+	static SLnode *pointer(uintptr_t link) { return (SLnode *)(link & ~(uintptr_t)1); };
+	static bool marked(uintptr_t link) { return (link & 1) != 0; };
+	static uintptr_t makeLink(SLnode *n, bool mark = false) { return (uintptr_t)n | (mark ? 1 : 0); };
+
+	int  compare(SLnode *, const string &);
+	int  randomLevel();
+	void track(SLnode *);
+	bool find(const string &, SLnode **, SLnode **);
+	void markAll(SLnode *);
+
+	SkipList(const SkipList &);
+	SkipList &operator=(const SkipList &);
+
+public:
+	SkipList();
+	~SkipList();
+
+	void insert(string, int = 1);
+	int Search(string);
+	int frequency(string);
+	bool remove(string);
+	long long size() const { return distinct.load(); };
+};
@@ -0,0 +1,213 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TOKENIZER_SSE2 1
+#endif
+
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+using namespace std;
+
+//************************************************************************
+// Tokenizer - splits a block of text into tokens in place. Nothing is
+// copied: every token is handed to a callback as (pointer, length) into
+// the original buffer.
+//
+// splitWords is for free text. A word byte is an ASCII letter, digit or
+// apostrophe, or any byte >= 0x80 so UTF-8 words stay whole; whitespace,
+// punctuation and control characters separate words.
+//
+// splitWhitespace is for word lists. Only spaces, tabs and line breaks
+// (anything <= ' ') separate tokens, so entries like "well-known" stay in
+// one piece.
+//
+// Case is left alone either way, the trees compare words exactly.
+//
+// With SSE2 the text is classified 16 bytes at a time and token edges are
+// found with bit scans on the resulting mask; the scalar tables handle
+// the tail and builds without SSE2.
+//************************************************************************
+
+namespace Tokenizer
+{
+	struct ByteTable
+	{
+		bool word[256];
+		bool text[256];
+
+		ByteTable()
+		{
+			for (int c = 0; c < 256; c++)
+			{
+				word[c] = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+					(c >= '0' && c <= '9') || c == '\'' || c >= 0x80;
+				text[c] = c > ' ';
+			}
+		}
+	};
+
+	inline const ByteTable &byteTable()
+	{
+		static const ByteTable table;
+		return table;
+	}
+
+	inline bool isWordByte(char c)
+	{
+		return byteTable().word[(unsigned char)c];
+	}
+
+	inline bool isTextByte(char c)
+	{
+		return byteTable().text[(unsigned char)c];
+	}
+
+	inline unsigned lowestBit(unsigned mask)
+	{
+#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return (unsigned)index;
+#else
+		return (unsigned)__builtin_ctz(mask);
+#endif
+	}
+
+	// Byte classes for splitRuns: mask() sets bit i when byte i of the 16
+	// at p belongs to a token, is() does the same for a single byte.
+
+	struct WordBytes
+	{
+#ifdef TOKENIZER_SSE2
+		static unsigned mask(const char *p)
+		{
+			__m128i b = _mm_loadu_si128((const __m128i *)p);
+			__m128i lower = _mm_or_si128(b, _mm_set1_epi8(0x20));
+			__m128i alpha = _mm_and_si128(_mm_cmpgt_epi8(lower, _mm_set1_epi8('a' - 1)),
+				_mm_cmplt_epi8(lower, _mm_set1_epi8('z' + 1)));
+			__m128i digit = _mm_and_si128(_mm_cmpgt_epi8(b, _mm_set1_epi8('0' - 1)),
+				_mm_cmplt_epi8(b, _mm_set1_epi8('9' + 1)));
+			__m128i apos = _mm_cmpeq_epi8(b, _mm_set1_epi8('\''));
+			__m128i ascii = _mm_or_si128(_mm_or_si128(alpha, digit), apos);
+
+			// sign bit of the raw byte covers everything >= 0x80
+			return (unsigned)(_mm_movemask_epi8(ascii) | _mm_movemask_epi8(b));
+		}
+#endif
+		static bool is(char c) { return isWordByte(c); }
+	};
+
+	struct TextBytes
+	{
+#ifdef TOKENIZER_SSE2
+		static unsigned mask(const char *p)
+		{
+			__m128i b = _mm_loadu_si128((const __m128i *)p);
+			__m128i visible = _mm_cmpgt_epi8(b, _mm_set1_epi8(' '));
+
+			return (unsigned)(_mm_movemask_epi8(visible) | _mm_movemask_epi8(b));
+		}
+#endif
+		static bool is(char c) { return isTextByte(c); }
+	};
+
+	//********************************************************************
+	// splitRuns - calls emit(const char *token, size_t length) for every
+	// maximal run of Bytes-class bytes in [begin, end). A token touching
+	// either end of the range is emitted as-is, so callers splitting a
+	// buffer into pieces should cut on a separator (see wordBoundary).
+	//********************************************************************
+
+	template <class Bytes, class Emit>
+	void splitRuns(const char *begin, const char *end, Emit emit)
+	{
+		const char *p = begin;
+		const char *start = NULL;
+		bool inToken = false;
+
+#ifdef TOKENIZER_SSE2
+		while (end - p >= 16)
+		{
+			unsigned mask = Bytes::mask(p);
+			unsigned pos = 0;
+
+			// fast path: the whole block continues the current state
+			if ((inToken && mask == 0xFFFF) || (!inToken && mask == 0))
+			{
+				p += 16;
+				continue;
+			}
+
+			while (pos < 16)
+			{
+				unsigned rest = (inToken ? ~mask : mask) & (0xFFFFu << pos) & 0xFFFFu;
+				if (!rest)
+					break;
+
+				unsigned bit = lowestBit(rest);
+				if (inToken)
+				{
+					emit(start, (size_t)(p + bit - start));
+					inToken = false;
+				}
+				else
+				{
+					start = p + bit;
+					inToken = true;
+				}
+				pos = bit + 1;
+			}
+			p += 16;
+		}
+#endif
+
+		for (; p < end; p++)
+		{
+			if (Bytes::is(*p))
+			{
+				if (!inToken)
+				{
+					start = p;
+					inToken = true;
+				}
+			}
+			else if (inToken)
+			{
+				emit(start, (size_t)(p - start));
+				inToken = false;
+			}
+		}
+
+		if (inToken)
+			emit(start, (size_t)(end - start));
+	}
+
+	template <class Emit>
+	void splitWords(const char *begin, const char *end, Emit emit)
+	{
+		splitRuns<WordBytes>(begin, end, emit);
+	}
+
+	template <class Emit>
+	void splitWhitespace(const char *begin, const char *end, Emit emit)
+	{
+		splitRuns<TextBytes>(begin, end, emit);
+	}
+
+	//********************************************************************
+	// wordBoundary - moves a proposed split point forward until it no
+	// longer falls in the middle of a word.
+	//********************************************************************
+
+	inline const char *wordBoundary(const char *begin, const char *cut, const char *end)
+	{
+		while (cut > begin && cut < end && isWordByte(cut[-1]) && isWordByte(*cut))
+			cut++;
+		return cut;
+	}
+}
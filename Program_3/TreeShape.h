@@ -0,0 +1,206 @@
+#pragma once
+#include <iostream>
+#include <vector>
+#include <map>
+#include <deque>
+#include <algorithm>
+
+using namespace std;
+
+//************************************************************************
+// ShapeReport - everything about a tree's shape from one O(n) pass:
+//
+//   height           levels in the tree (root alone = 1)
+//   depthHistogram   depthHistogram[d] = nodes at depth d (root is 1)
+//   averageDepth     mean node depth = comparisons for a uniformly chosen
+//                    key (what Search() would return)
+//   weightedDepth    the same, weighting each node by how many times its
+//                    key was inserted (count), i.e. the expected cost of
+//                    looking up a random token of the original input
+//   balanceHistogram right height - left height -> number of nodes
+//************************************************************************
+
+struct ShapeReport
+{
+	int height;
+	long long nodes;
+	long long keys;
+	double averageDepth;
+	double weightedDepth;
+	vector<long long> depthHistogram;
+	map<int, long long> balanceHistogram;
+
+	ShapeReport()
+	{
+		height = 0;
+		nodes = keys = 0;
+		averageDepth = weightedDepth = 0.0;
+	}
+
+	friend ostream &operator<<(ostream &output, const ShapeReport &r)
+	{
+		output << "Height = " << r.height << "\n"
+			<< "Nodes = " << r.nodes << "\n"
+			<< "Keys = " << r.keys << "\n"
+			<< "Average depth = " << r.averageDepth << "\n"
+			<< "Weighted depth = " << r.weightedDepth << "\n"
+			<< "Depth histogram:\n";
+		for (size_t d = 1; d < r.depthHistogram.size(); d++)
+		{
+			output << "\t" << d << ": " << r.depthHistogram[d] << "\n";
+		}
+		output << "Balance histogram:\n";
+		for (map<int, long long>::const_iterator it = r.balanceHistogram.begin(); it != r.balanceHistogram.end(); ++it)
+		{
+			output << "\t" << it->first << ": " << it->second << "\n";
+		}
+		return output;
+	}
+};
+
+//************************************************************************
+// measureShape - iterative post-order walk that fills a ShapeReport.
+// Depths are recorded on the way down, subtree heights on the way back
+// up, so balance factors come out of the same pass. Uses a stack as deep
+// as the tree instead of the call stack, so degenerate trees are fine.
+//
+// Works with any node type that has left, right and count members.
+//************************************************************************
+
+template <class Node>
+ShapeReport measureShape(Node *root)
+{
+	struct Frame
+	{
+		Node *n;
+		int depth;
+		int leftHeight;
+		int stage;
+	};
+
+	ShapeReport report;
+	vector<Frame> stack;
+	long long depthSum = 0;
+	long long weightedSum = 0;
+	int returned = 0;
+
+	if (!root)
+		return report;
+
+	Frame first = { root, 1, 0, 0 };
+	stack.push_back(first);
+
+	while (!stack.empty())
+	{
+		Frame &f = stack.back();
+
+		if (f.stage == 0)
+		{
+			if ((int)report.depthHistogram.size() <= f.depth)
+				report.depthHistogram.resize(f.depth + 1, 0);
+			report.depthHistogram[f.depth]++;
+			report.nodes++;
+			report.keys += f.n->count;
+			depthSum += f.depth;
+			weightedSum += (long long)f.depth * f.n->count;
+
+			f.stage = 1;
+			if (f.n->left)
+			{
+				Frame next = { f.n->left, f.depth + 1, 0, 0 };
+				stack.push_back(next);
+				continue;
+			}
+			returned = 0;
+		}
+
+		if (f.stage == 1)
+		{
+			f.leftHeight = returned;
+			f.stage = 2;
+			if (f.n->right)
+			{
+				Frame next = { f.n->right, f.depth + 1, 0, 0 };
+				stack.push_back(next);
+				continue;
+			}
+			returned = 0;
+		}
+
+		// both subtrees done, returned holds the right height
+		report.balanceHistogram[returned - f.leftHeight]++;
+		returned = 1 + max(returned, f.leftHeight);
+		stack.pop_back();
+	}
+
+	report.height = returned;
+	report.averageDepth = (double)depthSum / report.nodes;
+	report.weightedDepth = report.keys ? (double)weightedSum / report.keys : 0.0;
+
+	return report;
+}
+
+//************************************************************************
+// walkInorder - iterative inorder traversal calling visit(node) on every
+// node in key order. Keeps its own stack, so degenerate trees are fine.
+//************************************************************************
+
+template <class Node, class Visit>
+void walkInorder(Node *root, Visit visit)
+{
+	vector<Node *> stack;
+	Node *current = root;
+
+	while (current || !stack.empty())
+	{
+		while (current)
+		{
+			stack.push_back(current);
+			current = current->left;
+		}
+		current = stack.back();
+		stack.pop_back();
+
+		visit(current);
+		current = current->right;
+	}
+}
+
+//************************************************************************
+// writeLevelOrder - breadth first export, one line per level:
+//
+//     depth: key key key ...
+//
+// Lines are written as each level is finished, so only one level of the
+// tree is ever held in memory. key(node) returns what to print for a node.
+//************************************************************************
+
+template <class Node, class Key>
+void writeLevelOrder(Node *root, ostream &out, Key key)
+{
+	deque<Node *> level;
+	int depth = 1;
+
+	if (root)
+		level.push_back(root);
+
+	while (!level.empty())
+	{
+		size_t width = level.size();
+
+		out << depth << ":";
+		for (size_t i = 0; i < width; i++)
+		{
+			Node *n = level.front();
+			level.pop_front();
+
+			out << " " << key(n);
+			if (n->left)
+				level.push_back(n->left);
+			if (n->right)
+				level.push_back(n->right);
+		}
+		out << "\n";
+		depth++;
+	}
+}
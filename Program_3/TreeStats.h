@@ -0,0 +1,95 @@
+#pragma once
+#include <iostream>
+
+using namespace std;
+
+//************************************************************************
+// Tree instrumentation, chosen at compile time.
+//
+// Build with TREE_STATS defined (e.g. -DTREE_STATS or /DTREE_STATS) to
+// have AVLTree and BSTree count comparisons, rotations, nodes visited,
+// the deepest level reached and node allocations. Counts are kept for
+// the last operation (insert, Search, remove, ...) and as running totals.
+// A comparison is one three-way key compare at a node, the same unit
+// Search() returns.
+//
+// Without TREE_STATS the trees use NullInstrument, whose methods are all
+// empty inlines, so every hook compiles away and the stats calls just
+// return zeros.
+//
+// TREE_TRACE separately turns on the old debugging chatter in remove()
+// ("going left", printNode, ...).
+//************************************************************************
+
+struct TreeStats
+{
+	long long operations;
+	long long comparisons;
+	long long rotations;
+	long long nodesVisited;
+	long long allocations;
+	int maxDepth;
+
+	TreeStats()
+	{
+		operations = comparisons = rotations = nodesVisited = allocations = 0;
+		maxDepth = 0;
+	}
+
+	friend ostream &operator<<(ostream &output, const TreeStats &s)
+	{
+		output << "ops: " << s.operations
+			<< " comparisons: " << s.comparisons
+			<< " rotations: " << s.rotations
+			<< " visited: " << s.nodesVisited
+			<< " allocations: " << s.allocations
+			<< " max depth: " << s.maxDepth;
+		return output;
+	}
+};
+
+class CountingInstrument {
+
+private:
+	TreeStats total;
+	TreeStats last;
+
+public:
+	void begin() { last = TreeStats(); last.operations = 1; total.operations++; };
+	void compare(int n = 1) { last.comparisons += n; total.comparisons += n; };
+	void rotate() { last.rotations++; total.rotations++; };
+	void allocate() { last.allocations++; total.allocations++; };
+	void visit(int depth = 0)
+	{
+		last.nodesVisited++;
+		total.nodesVisited++;
+		if (depth > last.maxDepth)
+			last.maxDepth = depth;
+		if (depth > total.maxDepth)
+			total.maxDepth = depth;
+	};
+
+	TreeStats totals() const { return total; };
+	TreeStats lastOp() const { return last; };
+	void reset() { total = TreeStats(); last = TreeStats(); };
+};
+
+class NullInstrument {
+
+public:
+	void begin() {};
+	void compare(int = 1) {};
+	void rotate() {};
+	void allocate() {};
+	void visit(int = 0) {};
+
+	TreeStats totals() const { return TreeStats(); };
+	TreeStats lastOp() const { return TreeStats(); };
+	void reset() {};
+};
+
+#ifdef TREE_STATS
+typedef CountingInstrument TreeInstrument;
+#else
+typedef NullInstrument TreeInstrument;
+#endif
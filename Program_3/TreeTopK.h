@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+//************************************************************************
+// Top-k helpers shared by AVLTree::topK and BSTree::topK.
+//
+// best is a min-heap on count, so the least frequent of the best k seen
+// so far is on top and is the one a more frequent word replaces. Sorting
+// it with moreFrequent at the end puts the most frequent first.
+//************************************************************************
+
+inline bool moreFrequent(const pair<string, int> &a, const pair<string, int> &b)
+{
+	return a.second > b.second;
+}
+
+inline void offerTopK(vector<pair<string, int> > &best, int k, const string &word, int count)
+{
+	if ((int)best.size() < k)
+	{
+		best.push_back(make_pair(word, count));
+		push_heap(best.begin(), best.end(), moreFrequent);
+	}
+	else if (count > best.front().second)
+	{
+		pop_heap(best.begin(), best.end(), moreFrequent);
+		best.back() = make_pair(word, count);
+		push_heap(best.begin(), best.end(), moreFrequent);
+	}
+}
@@ -0,0 +1,117 @@
+#pragma once
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//************************************************************************
+// writeGraphViz - dumps a tree as a GraphViz digraph in one iterative
+// pass (http://www.webgraphviz.com/).
+//
+// Nodes are named by a numeric id (root is node0). Ids are handed out as
+// edges are written: when a node is written its children get the next two
+// ids, left then right, and nodes are written depth first, left subtree
+// before right. So siblings have consecutive ids, but the order is not
+// preorder. Duplicate keys can't collide and the same tree always produces
+// the same file. Missing children are drawn as small points, like before.
+//
+// maxDepth / maxNodes (0 = no limit) cap the output; a subtree that was
+// cut off is drawn as a "..." box so it's obvious the dump is partial.
+//
+// Output is collected in a large string and handed to the stream in big
+// writes. label(node) returns the text shown inside a node; quotes in it
+// are escaped here, "\\n" line breaks are left for GraphViz. Works with
+// any node type that has left and right members.
+//************************************************************************
+
+inline void vizEscape(string &buffer, const string &text)
+{
+	for (size_t i = 0; i < text.length(); i++)
+	{
+		if (text[i] == '"')
+			buffer += '\\';
+		buffer += text[i];
+	}
+}
+
+template <class Node, class Label>
+void writeGraphViz(Node *root, ostream &out, Label label, int maxDepth = 0, long long maxNodes = 0)
+{
+	struct Pending
+	{
+		Node *n;
+		long long id;
+		int depth;
+	};
+
+	const size_t flushAt = 1 << 20;
+	string buffer;
+	vector<Pending> stack;
+	long long nextId = 0;
+	long long nullCount = 0;
+	long long cutCount = 0;
+
+	buffer.reserve(flushAt + 4096);
+	buffer += "digraph G {\n";
+
+	if (root)
+	{
+		Pending first = { root, nextId++, 1 };
+		stack.push_back(first);
+	}
+
+	while (!stack.empty())
+	{
+		Pending p = stack.back();
+		stack.pop_back();
+
+		string id = "node" + to_string(p.id);
+		buffer += id + "[label=\"";
+		vizEscape(buffer, label(p.n));
+		buffer += "\"]\n";
+
+		Node *children[2] = { p.n->left, p.n->right };
+		Pending next[2];
+		int pushed = 0;
+
+		for (int c = 0; c < 2; c++)
+		{
+			Node *child = children[c];
+
+			if (!child)
+			{
+				string nid = "nnode" + to_string(++nullCount);
+				buffer += nid + "[label=\"X\",shape=point,width=.15]\n";
+				buffer += id + "->" + nid + "\n";
+			}
+			else if ((maxDepth > 0 && p.depth >= maxDepth) || (maxNodes > 0 && nextId >= maxNodes))
+			{
+				string cid = "cut" + to_string(++cutCount);
+				buffer += cid + "[label=\"...\",shape=box]\n";
+				buffer += id + "->" + cid + "\n";
+			}
+			else
+			{
+				Pending pending = { child, nextId++, p.depth + 1 };
+				next[pushed++] = pending;
+				buffer += id + "->node" + to_string(pending.id) + "\n";
+			}
+		}
+
+		// right goes on the stack first so the left subtree is written first
+		while (pushed > 0)
+		{
+			stack.push_back(next[--pushed]);
+		}
+
+		if (buffer.size() >= flushAt)
+		{
+			out.write(buffer.data(), buffer.size());
+			buffer.clear();
+		}
+	}
+
+	buffer += "}\n";
+	out.write(buffer.data(), buffer.size());
+}
@@ -0,0 +1,156 @@
+#include <string>
+#include <thread>
+#include <vector>
+#include "WordCounter.h"
+#include "Tokenizer.h"
+
+using namespace std;
+
+WordCounter::WordCounter(int workers)
+{
+	threads = workers;
+	if (threads <= 0)
+		threads = (int)thread::hardware_concurrency();
+	if (threads <= 0)
+		threads = 1;
+
+	tokenCount = 0;
+	byteCount = 0;
+}
+
+//************************************************************************
+// Method Name: countChunk
+//
+// Private
+//
+// Purpose: Tokenizes one chunk into a thread-local table of counts.
+//
+// Arguments: chunk bounds, table and token counter owned by the caller
+//
+// Returns: void
+//*************************************************************************
+
+void WordCounter::countChunk(const char *begin, const char *end, wordCounts &local, long long &seen)
+{
+	// rough guess at the vocabulary so the table doesn't rehash constantly
+	local.reserve(1 << 16);
+
+	Tokenizer::splitWords(begin, end, [&](const char *word, size_t length)
+	{
+		local[string_view(word, length)]++;
+		seen++;
+	});
+}
+
+//************************************************************************
+// Method Name: countBuffer
+//
+// Public
+//
+// Purpose: Splits a buffer into per-thread chunks on word boundaries,
+//          counts them in parallel, then folds the results into counts.
+//          The buffer must outlive the counter since the keys point
+//          into it.
+//
+// Arguments: buffer and its length
+//
+// Returns: void
+//*************************************************************************
+
+void WordCounter::countBuffer(const char *buffer, size_t length)
+{
+	const char *end = buffer + length;
+	int workers = threads;
+
+	// not worth a thread for less than a megabyte or so
+	if (length < ((size_t)workers << 20))
+		workers = (int)(length >> 20) + 1;
+
+	vector<const char *> cuts(workers + 1);
+	cuts[0] = buffer;
+	cuts[workers] = end;
+	for (int i = 1; i < workers; i++)
+	{
+		const char *cut = buffer + (length / workers) * i;
+		if (cut < cuts[i - 1])
+			cut = cuts[i - 1];
+		cuts[i] = Tokenizer::wordBoundary(buffer, cut, end);
+	}
+
+	vector<wordCounts> local(workers);
+	vector<long long> seen(workers, 0);
+	vector<thread> pool;
+
+	for (int i = 1; i < workers; i++)
+	{
+		pool.push_back(thread(&WordCounter::countChunk, this, cuts[i], cuts[i + 1], ref(local[i]), ref(seen[i])));
+	}
+	countChunk(cuts[0], cuts[1], local[0], seen[0]);
+
+	for (size_t i = 0; i < pool.size(); i++)
+	{
+		pool[i].join();
+	}
+
+	for (int i = 0; i < workers; i++)
+	{
+		if (counts.empty())
+		{
+			counts.swap(local[i]);
+		}
+		else
+		{
+			for (wordCounts::iterator it = local[i].begin(); it != local[i].end(); ++it)
+			{
+				counts[it->first] += it->second;
+			}
+		}
+		tokenCount += seen[i];
+	}
+	byteCount += length;
+}
+
+//************************************************************************
+// Method Name: countFile
+//
+// Public
+//
+// Purpose: Maps a file and counts the words in it. The mapping is kept
+//          until clear() so the counted words stay valid.
+//
+// Arguments: name of the file
+//
+// Returns: false if the file could not be opened
+//*************************************************************************
+
+bool WordCounter::countFile(string filename)
+{
+	unique_ptr<MappedFile> file(new MappedFile(filename));
+
+	if (!file->good())
+		return false;
+
+	countBuffer(file->data(), file->size());
+	files.push_back(move(file));
+	return true;
+}
+
+//************************************************************************
+// Method Name: clear
+//
+// Public
+//
+// Purpose: Forgets all counts and unmaps every file.
+//
+// Arguments: none
+//
+// Returns: void
+//*************************************************************************
+
+void WordCounter::clear()
+{
+	counts.clear();
+	files.clear();
+	tokenCount = 0;
+	byteCount = 0;
+}
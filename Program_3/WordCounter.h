@@ -0,0 +1,62 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include "MappedFile.h"
+
+using namespace std;
+
+typedef unordered_map<string_view, int> wordCounts;
+
+//************************************************************************
+// WordCounter - streaming word-frequency counter for large corpora.
+//
+// Each file is memory mapped and cut into one chunk per worker thread
+// (always on a word boundary). Every worker tokenizes its chunk and keeps
+// its own hash of counts, so there is no locking while counting; the
+// per-thread tables are folded together once the workers finish.
+//
+// Words are string_views into the mapped files, so the counter keeps
+// every file mapped until it is destroyed or clear() is called.
+// mergeInto() copies the totals into a counted AVLTree or BSTree.
+//************************************************************************
+
+class WordCounter {
+
+private:
+	int threads;
+	long long tokenCount;
+	long long byteCount;
+	wordCounts counts;
+	vector<unique_ptr<MappedFile> > files;
+
+	void countChunk(const char *, const char *, wordCounts &, long long &);
+
+public:
+	WordCounter(int workers = 0);
+
+	bool countFile(string);
+	void countBuffer(const char *, size_t);
+	void clear();
+
+	long long tokens() const { return tokenCount; };
+	long long bytes() const { return byteCount; };
+	size_t distinct() const { return counts.size(); };
+	const wordCounts &table() const { return counts; };
+
+	//********************************************************************
+	// mergeInto - adds every (word, count) into a tree. Build the tree in
+	// counted-key mode so each distinct word costs a single node.
+	//********************************************************************
+
+	template <class Tree>
+	void mergeInto(Tree &T) const
+	{
+		for (wordCounts::const_iterator it = counts.begin(); it != counts.end(); ++it)
+		{
+			T.insert(string(it->first), it->second);
+		}
+	}
+};
@@ -0,0 +1,39 @@
+#include <string>
+#include "WordFile.h"
+#include "Tokenizer.h"
+
+using namespace std;
+
+//************************************************************************
+// Method Name: load
+//
+// Public
+//
+// Purpose: Maps a word file and splits it on whitespace. Replaces
+//          anything loaded before.
+//
+// Arguments: name of the word file
+//
+// Returns: false if the file could not be opened
+//*************************************************************************
+
+bool WordFile::load(string filename)
+{
+	words.clear();
+
+	if (!file.open(filename))
+		return false;
+
+	const char *begin = file.data();
+	const char *end = begin + file.size();
+
+	// one word per short line is typical, so this rarely has to grow
+	words.reserve(file.size() / 8);
+
+	Tokenizer::splitWhitespace(begin, end, [&](const char *word, size_t length)
+	{
+		words.push_back(string_view(word, length));
+	});
+
+	return true;
+}
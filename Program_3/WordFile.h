@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+
+using namespace std;
+
+//************************************************************************
+// WordFile - loads a whitespace separated word list (adjectives.txt,
+// nouns.txt, ...) without copying it. The file is memory mapped and
+// split in place, and each word is a string_view into the mapping, so
+// the words are only valid while the WordFile is alive.
+//
+// The number of words is whatever the file holds; there is no count to
+// keep in sync with the data.
+//************************************************************************
+
+class WordFile {
+
+private:
+	MappedFile file;
+	vector<string_view> words;
+
+public:
+	WordFile() {};
+	WordFile(string filename) { load(filename); };
+
+	bool load(string);
+	bool good() const { return file.good(); };
+	size_t size() const { return words.size(); };
+	string_view operator[](size_t i) const { return words[i]; };
+	vector<string_view>::const_iterator begin() const { return words.begin(); };
+	vector<string_view>::const_iterator end() const { return words.end(); };
+};
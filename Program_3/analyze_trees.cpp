@@ -1,55 +1,409 @@
 #include <iostream>
+#include <algorithm>
 #include <fstream>
 #include <string>
 #include <vector>
+#include <chrono>
+#include <thread>
 #include "AVLTree.h"
 #include "BSTree.h"
+#include "SkipList.h"
+#include "LSMTree.h"
+#include "FrontCodedDict.h"
+#include "PerfectHashDict.h"
+#include "EytzingerDict.h"
+#include "LearnedIndex.h"
+#include "WordCounter.h"
+#include "WordFile.h"
 
 using namespace std;
 
-void loadTrees(string, BSTree &, AVLTree &, int);
+void loadTrees(string, BSTree &, AVLTree &);
+void streamFrequency(int, char **);
+void scaleTest(int);
+bool buildWordHash(string);
+uint64_t wordListStamp();
 
 ofstream outfile;
 ifstream infile;
 
-void main()
+void main(int argc, char **argv)
 {
+	// analyze_trees -freq corpus1 [corpus2 ...]
+	if (argc > 2 && string(argv[1]) == "-freq")
+	{
+		streamFrequency(argc - 2, argv + 2);
+		return;
+	}
+
+	// analyze_trees -genhash [table file]
+	if (argc > 1 && string(argv[1]) == "-genhash")
+	{
+		string table = argc > 2 ? argv[2] : "WordHash.bin";
+		cout << (buildWordHash(table) ? "Wrote " : "Could not write ") << table << endl;
+		return;
+	}
+
+	// analyze_trees -scale [maxThreads]
+	if (argc > 1 && string(argv[1]) == "-scale")
+	{
+		scaleTest(argc > 2 ? atoi(argv[2]) : 0);
+		return;
+	}
+
 	BSTree BST;
 	AVLTree AVL;
-	loadTrees("adjectives.txt", BST, AVL, 15572);
+	loadTrees("adjectives.txt", BST, AVL);
 	cout << "Adjectives done" << endl;
-	loadTrees("adverbs.txt", BST, AVL, 3238);
+	loadTrees("adverbs.txt", BST, AVL);
 	cout << "Adverbs done" << endl;
-	loadTrees("nouns.txt", BST, AVL, 25000);
+	loadTrees("nouns.txt", BST, AVL);
 	cout << "Nouns done" << endl;
-	loadTrees("verbs.txt", BST, AVL, 12019);
+	loadTrees("verbs.txt", BST, AVL);
 	cout << "Verbs done" << endl;
 	int BSTComp = 0;
 	int AVLComp = 0;
-	infile.open("tenthousandwords.txt");
-	string input;
-	while (!infile.eof())
+	WordFile queries("tenthousandwords.txt");
+	for (size_t i = 0; i < queries.size(); i++)
 	{
-		infile >> input;
+		string input(queries[i]);
 		BSTComp += BST.Search(input);
 		AVLComp += AVL.Search(input);
 	}
-	infile.close();
 	outfile.open("analysis.out");
 	outfile << "BST Comparisons = " << BSTComp << endl;
 	outfile << "AVL Comparisons = " << AVLComp << endl;
+	outfile << "BST Shape:\n" << BST.shape();
+	outfile << "AVL Shape:\n" << AVL.shape();
+#ifdef TREE_STATS
+	outfile << "BST Stats: " << BST.stats() << endl;
+	outfile << "AVL Stats: " << AVL.stats() << endl;
+#endif
 }
 
-void loadTrees(string filename, BSTree &B, AVLTree &A, int limit)
+void loadTrees(string filename, BSTree &B, AVLTree &A)
 {
-	infile.open(filename);
-	string input;
-	while (limit > 0)
+	WordFile words(filename);
+	for (size_t i = 0; i < words.size(); i++)
 	{
-		infile >> input;
+		string input(words[i]);
 		B.insert(input);
 		A.insert(input);
-		limit--;
 	}
-	infile.close();
+}
+
+// the dictionaries behind WordHash.bin
+static const char *wordLists[] = { "adjectives.txt", "adverbs.txt", "nouns.txt", "verbs.txt" };
+
+//************************************************************************
+// Function Name: buildWordHash
+//
+// Purpose: Builds the perfect hash table for the four dictionaries ahead of
+//          time, so PerfectHashDict::load only has to map it.
+//
+// Arguments: table file to write
+//
+// Returns: false if it could not be written
+//*************************************************************************
+
+bool buildWordHash(string table)
+{
+	vector<string> words;
+
+	for (int f = 0; f < 4; f++)
+	{
+		WordFile list(wordLists[f]);
+		words.insert(words.end(), list.begin(), list.end());
+	}
+	return PerfectHashDict::build(words, table, wordListStamp());
+}
+
+//************************************************************************
+// Function Name: wordListStamp
+//
+// Purpose: Hash of the four word files, stored in WordHash.bin so a table
+//          built from older lists is rebuilt instead of reused
+//
+// Returns: PerfectHashDict::hashFiles of the lists
+//*************************************************************************
+uint64_t wordListStamp()
+{
+	return PerfectHashDict::hashFiles(vector<string>(wordLists, wordLists + 4));
+}
+
+//************************************************************************
+// Function Name: streamFrequency
+//
+// Purpose: Counts every word in a set of (possibly huge) text files with
+//          the parallel WordCounter, merges the totals into a counted AVL
+//          tree and writes throughput and the most frequent words to
+//          frequency.out
+//
+// Arguments: number of files, file names
+//
+// Returns: void
+//*************************************************************************
+void streamFrequency(int count, char **names)
+{
+	WordCounter counter;
+	AVLTree AVL(true);
+
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < count; i++)
+	{
+		if (!counter.countFile(names[i]))
+		{
+			cout << "could not open " << names[i] << endl;
+		}
+	}
+	auto counted = chrono::steady_clock::now();
+	counter.mergeInto(AVL);
+	auto merged = chrono::steady_clock::now();
+
+	double countSecs = chrono::duration<double>(counted - start).count();
+	double mergeSecs = chrono::duration<double>(merged - counted).count();
+
+	outfile.open("frequency.out");
+	outfile << "Bytes = " << counter.bytes() << endl;
+	outfile << "Words = " << counter.tokens() << endl;
+	outfile << "Distinct = " << counter.distinct() << endl;
+	outfile << "Count seconds = " << countSecs << " (" << counter.bytes() / 1e6 / countSecs << " MB/s)" << endl;
+	outfile << "Merge seconds = " << mergeSecs << endl;
+
+	vector<pair<string, int> > top = AVL.topK(50);
+	for (size_t i = 0; i < top.size(); i++)
+	{
+		outfile << top[i].first << " " << top[i].second << endl;
+	}
+	outfile.close();
+}
+
+//************************************************************************
+// Function Name: timeEngine
+//
+// Purpose: Single threaded baseline: inserts every word into a dictionary
+//          engine, then searches every query, and writes the times and
+//          total comparisons to outfile.
+//
+// Arguments: engine name, engine, words to insert, words to search
+//
+// Returns: void
+//*************************************************************************
+
+template <class Engine>
+void timeEngine(string name, Engine &E, const vector<string> &words, const vector<string> &queries)
+{
+	long long comparisons = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (size_t i = 0; i < words.size(); i++)
+	{
+		E.insert(words[i]);
+	}
+	auto inserted = chrono::steady_clock::now();
+	for (size_t i = 0; i < queries.size(); i++)
+	{
+		comparisons += E.Search(queries[i]);
+	}
+	auto searched = chrono::steady_clock::now();
+
+	double insertSecs = chrono::duration<double>(inserted - start).count();
+
+	outfile << name << " threads = 1"
+		<< " insert seconds = " << insertSecs
+		<< " inserts/sec = " << words.size() / insertSecs
+		<< " search seconds = " << chrono::duration<double>(searched - inserted).count()
+		<< " comparisons = " << comparisons << endl;
+}
+
+//************************************************************************
+// Function Name: timeSearch
+//
+// Purpose: Times just the lookups, for read-only engines that are built
+//          from one of the trees.
+//
+// Arguments: engine name, engine, words to search
+//
+// Returns: void
+//*************************************************************************
+
+template <class Engine>
+void timeSearch(string name, Engine &E, const vector<string> &queries)
+{
+	long long comparisons = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (size_t i = 0; i < queries.size(); i++)
+	{
+		comparisons += E.Search(queries[i]);
+	}
+	auto searched = chrono::steady_clock::now();
+
+	outfile << name
+		<< " search seconds = " << chrono::duration<double>(searched - start).count()
+		<< " comparisons = " << comparisons << endl;
+}
+
+// lets timeSearch drive AVLTree::fingerSearch
+struct FingerSearch
+{
+	AVLTree &T;
+
+	int Search(const string &word) { return T.fingerSearch(word); }
+};
+
+//************************************************************************
+// Function Name: timeConcurrent
+//
+// Purpose: Same as timeEngine, but the words and queries are dealt out
+//          round robin to a number of threads sharing one engine.
+//
+// Arguments: engine name, engine, thread count, words, queries
+//
+// Returns: void
+//*************************************************************************
+
+template <class Engine>
+void timeConcurrent(string name, Engine &E, int threads, const vector<string> &words, const vector<string> &queries)
+{
+	vector<thread> pool;
+	vector<long long> comparisons(threads, 0);
+	long long total = 0;
+
+	auto start = chrono::steady_clock::now();
+	for (int t = 0; t < threads; t++)
+	{
+		pool.push_back(thread([&E, &words, t, threads]()
+		{
+			for (size_t i = t; i < words.size(); i += threads)
+			{
+				E.insert(words[i]);
+			}
+		}));
+	}
+	for (int t = 0; t < threads; t++)
+	{
+		pool[t].join();
+	}
+	pool.clear();
+
+	auto inserted = chrono::steady_clock::now();
+	for (int t = 0; t < threads; t++)
+	{
+		pool.push_back(thread([&E, &queries, &comparisons, t, threads]()
+		{
+			for (size_t i = t; i < queries.size(); i += threads)
+			{
+				comparisons[t] += E.Search(queries[i]);
+			}
+		}));
+	}
+	for (int t = 0; t < threads; t++)
+	{
+		pool[t].join();
+		total += comparisons[t];
+	}
+	auto searched = chrono::steady_clock::now();
+
+	double insertSecs = chrono::duration<double>(inserted - start).count();
+
+	outfile << name << " threads = " << threads
+		<< " insert seconds = " << insertSecs
+		<< " inserts/sec = " << words.size() / insertSecs
+		<< " search seconds = " << chrono::duration<double>(searched - inserted).count()
+		<< " comparisons = " << total << endl;
+}
+
+//************************************************************************
+// Function Name: scaleTest
+//
+// Purpose: Loads the four dictionaries into each engine and searches
+//          tenthousandwords.txt, writing timings to scaling.out. The trees
+//          and the LSM tree run single threaded, the read-only engines
+//          (front coded, perfect hash, Eytzinger, learned index) are
+//          timed on lookups only; the skip list is run with 1, 2, 4, ...
+//          threads up to maxThreads (default: twice the core count).
+//
+// Arguments: most threads to try (0 = default)
+//
+// Returns: void
+//*************************************************************************
+
+void scaleTest(int maxThreads)
+{
+	const char *files[] = { "adjectives.txt", "adverbs.txt", "nouns.txt", "verbs.txt" };
+	vector<string> words;
+	vector<string> queries;
+
+	for (int f = 0; f < 4; f++)
+	{
+		WordFile list(files[f]);
+		words.insert(words.end(), list.begin(), list.end());
+	}
+	WordFile queryFile("tenthousandwords.txt");
+	queries.assign(queryFile.begin(), queryFile.end());
+
+	if (maxThreads <= 0)
+		maxThreads = 2 * (int)thread::hardware_concurrency();
+	if (maxThreads <= 0)
+		maxThreads = 2;
+
+	outfile.open("scaling.out");
+	outfile << "Words = " << words.size() << " Queries = " << queries.size() << endl;
+
+	BSTree BST;
+	timeEngine("BST", BST, words, queries);
+
+	AVLTree AVL;
+	timeEngine("AVL", AVL, words, queries);
+
+	// sorted batch: root-first Search against the finger search
+	vector<string> sortedQueries(queries);
+	sort(sortedQueries.begin(), sortedQueries.end());
+	FingerSearch Finger = { AVL };
+	timeSearch("AVL sorted", AVL, sortedQueries);
+	timeSearch("AVL finger sorted", Finger, sortedQueries);
+
+	FrontCodedDict Compressed;
+	Compressed.build(AVL);
+	timeSearch("FrontCoded", Compressed, queries);
+	outfile << "FrontCoded words = " << Compressed.size()
+		<< " bytes = " << Compressed.bytes()
+		<< " (AVL nodes alone = " << AVL.shape().nodes * sizeof(node) << " bytes)" << endl;
+
+	PerfectHashDict Hashed;
+	uint64_t stamp = wordListStamp();
+	if (!Hashed.load("WordHash.bin", stamp) && buildWordHash("WordHash.bin"))
+		Hashed.load("WordHash.bin", stamp);
+	timeSearch("PerfectHash", Hashed, queries);
+	outfile << "PerfectHash words = " << Hashed.size()
+		<< " bytes = " << Hashed.bytes() << endl;
+
+	EytzingerDict Eytzinger;
+	Eytzinger.build(AVL);
+	timeSearch("Eytzinger", Eytzinger, queries);
+	outfile << "Eytzinger words = " << Eytzinger.size()
+		<< " bytes = " << Eytzinger.bytes() << endl;
+
+	LearnedIndex Learned;
+	Learned.build(AVL);
+	timeSearch("Learned", Learned, queries);
+	outfile << "Learned words = " << Learned.size()
+		<< " bytes = " << Learned.bytes()
+		<< " knots = " << Learned.knotCount()
+		<< " window = " << Learned.window() << endl;
+
+	// small buffer so the dictionaries spill into several runs
+	LSMTree LSM(4096);
+	timeEngine("LSM", LSM, words, queries);
+	outfile << "LSM runs = " << LSM.runCount()
+		<< " merges = " << LSM.mergeCount()
+		<< " read amplification = " << LSM.readAmplification() << endl;
+
+	for (int threads = 1; threads <= maxThreads; threads *= 2)
+	{
+		SkipList Skip;
+		timeConcurrent("SkipList", Skip, threads, words, queries);
+	}
+	outfile.close();
 }
\ No newline at end of file
@@ -1,31 +1,37 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <time.h>
+#include "WordFile.h"
 
 using namespace std;
 
-typedef vector<string> wordlist;
+typedef vector<string_view> wordlist;
 
 ofstream outfile2;
-ifstream infile2;
 
-wordlist loadList(string, int);
+wordlist loadList(const WordFile &);
 
 void other()
 {
 	srand(time(NULL));
-	wordlist Adjective = loadList("adjectives.txt", 15572);
-	wordlist Adverb = loadList("adverbs.txt", 3238);
-	wordlist Noun = loadList("nouns.txt", 25000);
-	wordlist Verb = loadList("verbs.txt", 12019);
+	// the word files must stay open while their words are in use
+	WordFile Adjectives("adjectives.txt");
+	WordFile Adverbs("adverbs.txt");
+	WordFile Nouns("nouns.txt");
+	WordFile Verbs("verbs.txt");
+	wordlist Adjective = loadList(Adjectives);
+	wordlist Adverb = loadList(Adverbs);
+	wordlist Noun = loadList(Nouns);
+	wordlist Verb = loadList(Verbs);
 	int adv = 0;
 	outfile2.open("tenthousandwords.txt");
 	for (int i = 0; i < 10000; i++)
 	{
-		if (adv > 3238)
-			adv = adv % 3238;
+		if (adv >= (int)Adverb.size())
+			adv = adv % Adverb.size();
 		if ((i % 3) == 0)
 			outfile2 << Adjective[i] << " " << Noun[i] << " " << Verb[i] << endl;
 		else if ((i % 5) == 0)
@@ -36,26 +42,35 @@ void other()
 	outfile2.close();
 }
 
-wordlist loadList(string fileName, int wordTotal)
+//************************************************************************
+// Function Name: loadList
+//
+// Purpose: Scatters the words of an already loaded word file into random
+//          slots of a list.
+//
+// Arguments: word file to shuffle (must outlive the returned list)
+//
+// Returns: wordlist of views into the word file
+//*************************************************************************
+wordlist loadList(const WordFile &words)
 {
-	string input;
+	int wordTotal = (int)words.size();
 	wordlist wList;
-	wList.assign(wordTotal, " ");
+	wList.assign(wordTotal, string_view());
 	int num;
 	int counter = 0;
-	infile2.open(fileName);
 	while (counter < wordTotal)
 	{
-		infile2 >> input;
+		string_view input = words[counter];
 		num = rand() % wordTotal;
-		if (wList[num] == " ")
+		if (wList[num].empty())
 			wList[num] = input;
 		else 
 			while (num > -1)
 			{
 				if (num == wordTotal)
 					num = 0;
-				else if (wList[num] == " ")
+				else if (wList[num].empty())
 				{
 					wList[num] = input;
 					num = -2;
@@ -65,8 +80,5 @@ wordlist loadList(string fileName, int wordTotal)
 			}
 		counter++;
 	}
-	infile2.clear();
-	infile2.close();
 	return wList;
-}
-	
\ No newline at end of file
+}
\ No newline at end of file
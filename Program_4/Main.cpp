@@ -2,153 +2,198 @@
 #include <fstream>
 #include <string>
 #include <vector>
+#include <deque>
+#include <unordered_set>
+#include <thread>
 #include "graph.h"
+#include "ingest.h"
+#include "csr.h"
 
 using namespace std;
 
 
 
-void filterDups(string, string);
-graph loadGraphCSV(string, int max);
+graph loadGraphCSV(string, int max = 0, int threads = 1);
 
 void main()
 {
-	graph G1;
-	//filterDups("cities.csv", "filtered_cities.csv");
-	G1 = loadGraphCSV("filtered_cities.csv", 0);
-	G1.lookupHelp();
-	//int test = G1.cityLookup["Lebanon"];
-	G1.createForest("Lebanon");
+	// the forest from the last run, if there is one and the cities haven't
+	// changed since
+	graph G1("cities.graph", "filtered_cities.csv");
+	if (G1.vertexList.empty())
+	{
+		//cityIngest(cityIngest::byCity).run("cities.csv", "filtered_cities.csv", "rejects.csv");
+		G1 = loadGraphCSV("filtered_cities.csv", 0, 0);
+		G1.lookupHelp();
+		//int test = G1.cityLookup["Lebanon"];
+		G1.createForest("Lebanon");
+		G1.saveSnapshot("cities.graph", "filtered_cities.csv");
+	}
+
+	vector<int> component;
+	csrGraph C(G1);
+	cout << C.components(component) << " components" << endl;
 	//G1.connectForest();
 	system("pause");
 }
 
 /**
-* loadGraphCSV - loads a graph with the given csv
+* splitLines - cuts a buffer into parts of about equal size, moving each
+* cut forward to just past a newline so no row is split. Rows must not
+* have quoted newlines in them, as only the newlines are looked at.
 * Params:
-*     string filename  - filename to open
+*     const char* data   - start of the buffer
+*     size_t size        - its length
+*     int parts          - how many parts wanted
 * Returns
-*     graph
+*     vector of [begin, end) pairs, in file order (some may be empty)
 */
-graph loadGraphCSV(string filename, int max = 0)
+vector<pair<const char *, const char *> > splitLines(const char *data, size_t size, int parts)
 {
-	int zip;
-	double lat;
-	double lon;
-	string city;
-	string state;
-	string county;
-
-	map<string, int> cityCheck;
+	vector<pair<const char *, const char *> > chunks;
+	const char *end = data + size;
+	const char *begin = data;
 
-	int i = 0;
-
-	graph G;
-	int vid;
-	vertex *temp;
-
-	ifstream file(filename);
-
-	for (CSVIterator loop(file); loop != CSVIterator(); ++loop)
+	for (int c = 1; c <= parts; c++)
 	{
-		zip = stoi((*loop)[0]);
-		if ((*loop)[1].length() > 0)
+		const char *cut = data + size * c / parts;
+		if (cut < begin)
 		{
-			lat = stod((*loop)[1]);
+			cut = begin;
 		}
-		else
+		if (c < parts && cut > data && cut < end && cut[-1] != '\n')
 		{
-			lat = 0.0;
+			const char *newline = (const char *)memchr(cut, '\n', end - cut);
+			cut = newline ? newline + 1 : end;
 		}
+		chunks.push_back(make_pair(begin, cut));
+		begin = cut;
+	}
+	return chunks;
+}
 
-		if ((*loop)[2].length() > 0)
-		{
-			lon = stod((*loop)[2]);
-		}
-		else
+/**
+* parseCities - parses one chunk of a city file into records, keeping only
+* the first row for each city name within the chunk.
+* Params:
+*     const char* begin     - first row of the chunk
+*     const char* end       - end of the chunk
+*     vector<cityRecord>& batch - records in file order
+*     deque<string>& copies - holds fields that had to be unescaped, so
+*                             the records can keep pointing at them
+* Returns
+*     void
+*/
+void parseCities(const char *begin, const char *end, vector<cityRecord> &batch, deque<string> &copies)
+{
+	unordered_set<string_view> seen;
+	CSVRowView row;
+	cityRecord rec;
+	string buffer;
+	const char *p = begin;
+
+	// unescaped fields live in buffer, which the next row reuses
+	auto keep = [&](string_view &field) {
+		if (!field.empty() && (field.data() < begin || field.data() >= end))
 		{
-			lon = 0.0;
+			copies.push_back(string(field));
+			field = copies.back();
 		}
+	};
 
-		city = (*loop)[3];
-		state = (*loop)[4];
-		county = (*loop)[5];
-
-		if (cityCheck.find(city) == cityCheck.end())
+	while (p < end)
+	{
+		p = CSVReader::parseRow(p, end, row, buffer);
+		if (!citySchema.parse(row, rec))
 		{
-			// Add the city as a key to the map.
-			cityCheck[city] = 0;
-			if ((int)lat == 0 || (int)lon == 0)
-			{
-				cout << "oops: " << city << ", " << state << ", " << lat << ", " << lon << endl;
-			}
-			vid = G.addVertex(city, state, lat, lon);
-			i++;
+			continue;
 		}
 
-		if (i > max && max != 0)
+		keep(rec.city);
+		keep(rec.state);
+		keep(rec.county);
+
+		if (seen.insert(rec.city).second)
 		{
-			return G;
+			batch.push_back(rec);
 		}
 	}
-
-	return G;
 }
 
 /**
-* filterDups - filters out duplicate cities and creates new output file
+* loadGraphCSV - loads a graph with the given csv
+*
+* The file is mapped and cut into one chunk per thread at row boundaries.
+* Each thread parses its chunk into a batch of records in place (numbers
+* with from_chars, names as views into the file). The batches are then
+* merged in file order, so the first row for each city wins and vertex IDs
+* come out the same whatever the thread count.
 * Params:
 *     string filename  - filename to open
-*     string outfile   - filename to write to
+*     int max          - stop after this many cities (0 = all)
+*     int threads      - threads to parse with (0 = one per core)
 * Returns
 *     graph
 */
-void filterDups(string filename, string outfile)
+graph loadGraphCSV(string filename, int max, int threads)
 {
-	int zip;
-	double lat;
-	double lon;
-	string city;
-	string state;
-	string county;
+	graph G;
+	CSVReader file(filename);
 
-	map<string, int> cityCheck;
+	if (!file.good() || file.size() == 0)
+	{
+		return G;
+	}
 
-	int i = 0;
+	if (threads < 1)
+	{
+		threads = (int)thread::hardware_concurrency();
+	}
+	if (threads < 1)
+	{
+		threads = 1;
+	}
 
-	ifstream file(filename);
-	ofstream out(outfile);
+	vector<pair<const char *, const char *> > chunks = splitLines(file.data(), file.size(), threads);
+	vector<vector<cityRecord> > batches(chunks.size());
+	vector<deque<string> > copies(chunks.size());
+	vector<thread> pool;
 
-	for (CSVIterator loop(file); loop != CSVIterator(); ++loop)
+	for (size_t c = 0; c < chunks.size(); c++)
 	{
-		zip = stoi((*loop)[0]);
-		if ((*loop)[1].length() > 0)
-		{
-			lat = stod((*loop)[1]);
-		}
-		else
-		{
-			lat = 0.0;
-		}
-
-		if ((*loop)[2].length() > 0)
-		{
-			lon = stod((*loop)[2]);
-		}
-		else
-		{
-			lon = 0.0;
-		}
+		pool.push_back(thread(parseCities, chunks[c].first, chunks[c].second, ref(batches[c]), ref(copies[c])));
+	}
+	for (size_t c = 0; c < pool.size(); c++)
+	{
+		pool[c].join();
+	}
 
-		city = (*loop)[3];
-		state = (*loop)[4];
-		county = (*loop)[5];
+	unordered_set<string_view> cityCheck;
+	vector<cityRecord> cities;
 
-		if (cityCheck.find(city) == cityCheck.end() && abs(lat) > 0 && abs(lon) > 0)
+	for (size_t c = 0; c < batches.size(); c++)
+	{
+		for (size_t r = 0; r < batches[c].size(); r++)
 		{
-			// Add the city as a key to the map.
-			cityCheck[city] = 0;
-			out << zip << "," << lat << "," << lon << "," << city << "," << state << "," << county << "\n";
+			const cityRecord &rec = batches[c][r];
+
+			if (cityCheck.insert(rec.city).second)
+			{
+				if ((int)rec.lat == 0 || (int)rec.lon == 0)
+				{
+					cout << "oops: " << rec.city << ", " << rec.state << ", " << rec.lat << ", " << rec.lon << endl;
+				}
+				cities.push_back(rec);
+
+				if ((int)cities.size() > max && max != 0)
+				{
+					G.addVertices(cities, threads);
+					return G;
+				}
+			}
 		}
 	}
-}
\ No newline at end of file
+
+	G.addVertices(cities, threads);
+	return G;
+}
@@ -0,0 +1,245 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <limits>
+#include <algorithm>
+#include "graph.h"
+
+using namespace std;
+
+/**
+ * csrGraph - a read-only compressed sparse row copy of a graph's edges.
+ *
+ * The edges of vertex v are neighbors[offsets[v]] .. neighbors[offsets[v+1]-1]
+ * with matching weights, so a traversal walks three flat arrays instead of
+ * following a pointer to each vertex and then to its edge vector. Vertex
+ * IDs are the same as in the graph it was built from. Build it once the
+ * graph is done changing; it does not see later edits.
+ *
+ *     csrGraph C(G);
+ *     vector<int> path = C.shortestPath(G.cityLookup["Lebanon"], G.cityLookup["Dallas"]);
+ */
+struct csrGraph
+{
+    vector<int> offsets;     // vertexCount() + 1 entries
+    vector<int> neighbors;   // toID of each edge, grouped by fromID
+    vector<double> weights;  // weight of each edge
+
+    csrGraph() { offsets.assign(1, 0); }
+    csrGraph(const graph &G) { build(G); }
+
+    /**
+     * build - copies the edges of G, in one pass over its vertices
+     * Params:
+     *     const graph& G: graph to copy
+     * Returns
+     *     void
+     */
+    void build(const graph &G)
+    {
+        size_t n = G.vertexList.size();
+        size_t m = 0;
+
+        for (size_t v = 0; v < n; v++)
+        {
+            m += G.vertexList[v]->E.size();
+        }
+
+        offsets.assign(n + 1, 0);
+        neighbors.resize(m);
+        weights.resize(m);
+
+        size_t e = 0;
+        for (size_t v = 0; v < n; v++)
+        {
+            const vector<edge> &E = G.vertexList[v]->E;
+            offsets[v] = (int)e;
+            for (size_t i = 0; i < E.size(); i++, e++)
+            {
+                neighbors[e] = E[i].toID;
+                weights[e] = E[i].weight;
+            }
+        }
+        offsets[n] = (int)e;
+    }
+
+    int vertexCount() const { return (int)offsets.size() - 1; }
+    int edgeCount() const { return (int)neighbors.size(); }
+    int degree(int v) const { return offsets[v + 1] - offsets[v]; }
+
+    /**
+     * bfs - breadth first search from one vertex
+     * Params:
+     *     int start: vertex to start from
+     * Returns
+     *     vector<int>: hops from start to each vertex (-1 = unreachable)
+     */
+    vector<int> bfs(int start) const
+    {
+        vector<int> hops(vertexCount(), -1);
+        vector<int> frontier;
+
+        if (start < 0 || start >= vertexCount())
+        {
+            return hops;
+        }
+
+        hops[start] = 0;
+        frontier.push_back(start);
+
+        // frontier doubles as the queue: [head, size) is still to visit
+        for (size_t head = 0; head < frontier.size(); head++)
+        {
+            int v = frontier[head];
+            for (int e = offsets[v]; e < offsets[v + 1]; e++)
+            {
+                int w = neighbors[e];
+                if (hops[w] < 0)
+                {
+                    hops[w] = hops[v] + 1;
+                    frontier.push_back(w);
+                }
+            }
+        }
+        return hops;
+    }
+
+    /**
+     * dijkstra - shortest weighted distances from one vertex (weights
+     *     must not be negative)
+     * Params:
+     *     int source: vertex to start from
+     *     vector<double>& dist: filled with the distance to each vertex
+     *                           (infinity = unreachable)
+     *     vector<int>& prev: filled with the vertex before each one on its
+     *                        shortest path (-1 for source / unreachable)
+     * Returns
+     *     void
+     */
+    void dijkstra(int source, vector<double> &dist, vector<int> &prev) const
+    {
+        typedef pair<double, int> entry;
+        priority_queue<entry, vector<entry>, greater<entry> > open;
+
+        dist.assign(vertexCount(), numeric_limits<double>::infinity());
+        prev.assign(vertexCount(), -1);
+
+        if (source < 0 || source >= vertexCount())
+        {
+            return;
+        }
+
+        dist[source] = 0;
+        open.push(entry(0, source));
+
+        while (!open.empty())
+        {
+            entry top = open.top();
+            open.pop();
+
+            int v = top.second;
+            if (top.first > dist[v])
+            {
+                continue; // stale: v was reached more cheaply since
+            }
+            for (int e = offsets[v]; e < offsets[v + 1]; e++)
+            {
+                int w = neighbors[e];
+                double d = top.first + weights[e];
+                if (d < dist[w])
+                {
+                    dist[w] = d;
+                    prev[w] = v;
+                    open.push(entry(d, w));
+                }
+            }
+        }
+    }
+
+    /**
+     * shortestPath - cheapest path between two vertices
+     * Params:
+     *     int from: first vertex
+     *     int to: last vertex
+     * Returns
+     *     vector<int>: vertex IDs from `from` to `to`, empty if there is
+     *                  no path
+     */
+    vector<int> shortestPath(int from, int to) const
+    {
+        vector<double> dist;
+        vector<int> prev;
+        vector<int> path;
+
+        dijkstra(from, dist, prev);
+        if (to < 0 || to >= vertexCount() || dist[to] == numeric_limits<double>::infinity())
+        {
+            return path;
+        }
+        for (int v = to; v != -1; v = prev[v])
+        {
+            path.push_back(v);
+        }
+        reverse(path.begin(), path.end());
+        return path;
+    }
+
+    /**
+     * components - labels the connected components, following edges in
+     *     either direction
+     * Params:
+     *     vector<int>& label: filled with the component of each vertex,
+     *                         numbered from 0
+     * Returns
+     *     int: how many components there are
+     */
+    int components(vector<int> &label) const
+    {
+        int n = vertexCount();
+        vector<int> parent(n);
+
+        for (int v = 0; v < n; v++)
+        {
+            parent[v] = v;
+        }
+
+        // union-find, so directed edges join components too
+        for (int v = 0; v < n; v++)
+        {
+            for (int e = offsets[v]; e < offsets[v + 1]; e++)
+            {
+                int a = findRoot(parent, v);
+                int b = findRoot(parent, neighbors[e]);
+                if (a != b)
+                {
+                    parent[max(a, b)] = min(a, b);
+                }
+            }
+        }
+
+        int count = 0;
+        label.assign(n, -1);
+        for (int v = 0; v < n; v++)
+        {
+            int root = findRoot(parent, v);
+            if (label[root] < 0)
+            {
+                label[root] = count++;
+            }
+            label[v] = label[root];
+        }
+        return count;
+    }
+
+  private:
+    static int findRoot(vector<int> &parent, int v)
+    {
+        while (parent[v] != v)
+        {
+            parent[v] = parent[parent[v]];
+            v = parent[v];
+        }
+        return v;
+    }
+};
@@ -1,18 +1,33 @@
+#pragma once
+
 #include <iterator>
-#include <iostream>
-#include <fstream>
-#include <sstream>
 #include <vector>
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <cstring>
+#include <tuple>
+#include "mapped_file.h"
 
 /**
  * A csv helper class to read csv files a little easier.
+ *
+ * CSVReader maps the whole file and hands out rows as string_views
+ * pointing straight into the mapping, so reading a row allocates nothing
+ * (the row's vector keeps its capacity from one row to the next).
+ *
+ * Fields may be quoted ("Washington, D.C."), and a quoted field may hold
+ * commas, newlines and doubled quotes (""). The quotes are not part of
+ * the field. A field with doubled quotes is the only one that can't
+ * point into the file: it is unescaped into a buffer the reader reuses,
+ * so it is only valid until the next row is read. Every other field is
+ * valid while the reader is open. \r\n line ends are fine.
  */
 
-class CSVRow
+class CSVRowView
 {
     public:
-        std::string const& operator[](std::size_t index) const
+        std::string_view const& operator[](std::size_t index) const
         {
             return m_data[index];
         }
@@ -20,59 +35,361 @@ class CSVRow
         {
             return m_data.size();
         }
-        void readNextRow(std::istream& str)
+    private:
+        friend class CSVReader;
+
+        struct Unescaped
+        {
+            std::size_t field;  // index into m_data
+            std::size_t offset; // where it starts in the reader's buffer
+            std::size_t length;
+        };
+
+        std::vector<std::string_view> m_data;
+        std::vector<Unescaped>        m_unescaped;
+};
+
+class CSVReader
+{
+    public:
+        CSVReader() : m_pos(NULL), m_end(NULL) {}
+        CSVReader(std::string filename) : m_pos(NULL), m_end(NULL) { open(filename); }
+
+        /**
+         * open - maps a csv file and rewinds to its first row
+         * Params:
+         *     string filename  - file to read
+         * Returns
+         *     bool: true if the file could be opened
+         */
+        bool open(std::string filename)
+        {
+            if (!m_file.open(filename))
+            {
+                m_pos = m_end = NULL;
+                return false;
+            }
+            m_pos = m_file.data();
+            m_end = m_pos + m_file.size();
+            return true;
+        }
+
+        bool good() const { return m_file.good(); }
+        const char *data() const { return m_file.data(); }
+        std::size_t size() const { return m_file.size(); }
+
+        /**
+         * readNextRow - splits the next row into fields
+         * Params:
+         *     CSVRowView& row  - filled with the fields of the row
+         * Returns
+         *     bool: false at the end of the file
+         */
+        bool readNextRow(CSVRowView& row)
+        {
+            if (m_pos >= m_end)
+            {
+                return false;
+            }
+            m_pos = parseRow(m_pos, m_end, row, m_buffer);
+            return true;
+        }
+
+        /**
+         * readNextRecord - reads rows until one fits the schema and parses
+         *     it into a record
+         * Params:
+         *     const Schema& schema  - see CSVSchema
+         *     Record& out           - record to fill
+         * Returns
+         *     bool: false at the end of the file
+         */
+        template <class Schema>
+        bool readNextRecord(const Schema& schema, typename Schema::record_type& out)
         {
-            std::string         line;
-            std::getline(str, line);
+            while (readNextRow(m_row))
+            {
+                if (schema.parse(m_row, out))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
 
-            std::stringstream   lineStream(line);
-            std::string         cell;
+        /**
+         * parseRow - splits the row starting at p into fields. Used by
+         *     readNextRow, and by anything that walks its own slice of a
+         *     mapped file.
+         * Params:
+         *     const char* p      - first byte of the row
+         *     const char* end    - end of the data
+         *     CSVRowView& row    - filled with the fields of the row
+         *     string& buffer     - where fields with "" escapes are unescaped
+         * Returns
+         *     const char*: first byte of the next row
+         */
+        static const char *parseRow(const char *p, const char *end, CSVRowView& row, std::string& buffer)
+        {
+            row.m_data.clear();
+            row.m_unescaped.clear();
+            buffer.clear();
 
-            m_data.clear();
-            while(std::getline(lineStream, cell, ','))
+            while (true)
             {
-                m_data.push_back(cell);
+                if (p < end && *p == '"')
+                {
+                    p = quotedField(p + 1, end, row, buffer);
+                    // anything between the closing quote and the comma is dropped
+                    while (p < end && *p != ',' && *p != '\n')
+                    {
+                        p++;
+                    }
+                }
+                else
+                {
+                    const char *start = p;
+                    while (p < end && *p != ',' && *p != '\n')
+                    {
+                        p++;
+                    }
+                    const char *stop = p;
+                    if (stop > start && stop[-1] == '\r')
+                    {
+                        stop--;
+                    }
+                    row.m_data.push_back(std::string_view(start, stop - start));
+                }
+
+                if (p < end && *p == ',')
+                {
+                    p++;
+                    continue;
+                }
+                if (p < end)
+                {
+                    p++; // the newline
+                }
+                break;
             }
-            // This checks for a trailing comma with no data after it.
-            if (!lineStream && cell.empty())
+
+            // the buffer has stopped growing, so its fields can be pointed at
+            for (std::size_t i = 0; i < row.m_unescaped.size(); i++)
             {
-                // If there was a trailing comma then add an empty element.
-                m_data.push_back("");
+                CSVRowView::Unescaped& u = row.m_unescaped[i];
+                row.m_data[u.field] = std::string_view(buffer.data() + u.offset, u.length);
             }
+            return p;
         }
+
     private:
-        std::vector<std::string>    m_data;
-};
+        /**
+         * quotedField - reads a quoted field whose opening quote has been
+         *     consumed. Fields without "" point into the file; the rest
+         *     are copied into buffer with the doubled quotes collapsed.
+         * Returns
+         *     const char*: the byte after the closing quote
+         */
+        static const char *quotedField(const char *p, const char *end, CSVRowView& row, std::string& buffer)
+        {
+            const char *start = p;
+            bool escaped = false;
+            std::size_t offset = buffer.size();
 
-std::istream& operator>>(std::istream& str, CSVRow& data)
-{
-    data.readNextRow(str);
-    return str;
-}
+            while (true)
+            {
+                const char *quote = (const char *)std::memchr(p, '"', end - p);
+                if (!quote)
+                {
+                    quote = end; // unterminated: take the rest of the file
+                }
+                if (quote + 1 < end && quote[1] == '"')
+                {
+                    buffer.append(p, quote + 1 - p);
+                    escaped = true;
+                    p = quote + 2;
+                    continue;
+                }
+                if (escaped)
+                {
+                    buffer.append(p, quote - p);
+                    CSVRowView::Unescaped u = { row.m_data.size(), offset, buffer.size() - offset };
+                    row.m_unescaped.push_back(u);
+                    row.m_data.push_back(std::string_view());
+                }
+                else
+                {
+                    row.m_data.push_back(std::string_view(start, quote - start));
+                }
+                return quote < end ? quote + 1 : end;
+            }
+        }
+
+        MappedFile  m_file;
+        const char *m_pos;
+        const char *m_end;
+        std::string m_buffer;
+        CSVRowView  m_row;
+};
 
 class CSVIterator
-{   
+{
     public:
         typedef std::input_iterator_tag     iterator_category;
-        typedef CSVRow                      value_type;
+        typedef CSVRowView                  value_type;
         typedef std::size_t                 difference_type;
-        typedef CSVRow*                     pointer;
-        typedef CSVRow&                     reference;
+        typedef CSVRowView*                 pointer;
+        typedef CSVRowView&                 reference;
 
-        CSVIterator(std::istream& str)  :m_str(str.good()?&str:NULL) { ++(*this); }
-        CSVIterator()                   :m_str(NULL) {}
+        CSVIterator(CSVReader& reader)  :m_reader(reader.good()?&reader:NULL) { ++(*this); }
+        CSVIterator()                   :m_reader(NULL) {}
 
         // Pre Increment
-        CSVIterator& operator++()               {if (m_str) { if (!((*m_str) >> m_row)){m_str = NULL;}}return *this;}
+        CSVIterator& operator++()               {if (m_reader) { if (!m_reader->readNextRow(m_row)){m_reader = NULL;}}return *this;}
         // Post increment
         CSVIterator operator++(int)             {CSVIterator    tmp(*this);++(*this);return tmp;}
-        CSVRow const& operator*()   const       {return m_row;}
-        CSVRow const* operator->()  const       {return &m_row;}
+        CSVRowView const& operator*()   const   {return m_row;}
+        CSVRowView const* operator->()  const   {return &m_row;}
 
-        bool operator==(CSVIterator const& rhs) {return ((this == &rhs) || ((this->m_str == NULL) && (rhs.m_str == NULL)));}
+        bool operator==(CSVIterator const& rhs) {return ((this == &rhs) || ((this->m_reader == NULL) && (rhs.m_reader == NULL)));}
         bool operator!=(CSVIterator const& rhs) {return !((*this) == rhs);}
     private:
-        std::istream*       m_str;
-        CSVRow              m_row;
+        CSVReader*          m_reader;
+        CSVRowView          m_row;
+};
+
+/**
+ * csvConvert - turns one field into a typed value in place (from_chars
+ * for numbers, so no copy and no locale). Returns false for an empty or
+ * unparsable field, leaving value alone.
+ */
+template <class T>
+inline bool csvConvert(std::string_view field, T& value)
+{
+    T parsed;
+    if (field.empty() || std::from_chars(field.data(), field.data() + field.size(), parsed).ec != std::errc())
+    {
+        return false;
+    }
+    value = parsed;
+    return true;
+}
+
+inline bool csvConvert(std::string_view field, std::string_view& value)
+{
+    if (field.empty())
+    {
+        return false;
+    }
+    value = field;
+    return true;
+}
+
+inline bool csvConvert(std::string_view field, std::string& value)
+{
+    if (field.empty())
+    {
+        return false;
+    }
+    value.assign(field.data(), field.size());
+    return true;
+}
+
+/**
+ * CSVColumn - binds column `index` of a row to one member of a record,
+ * with the value to use when the field is empty or won't parse.
+ */
+template <class Record, class T>
+struct CSVColumn
+{
+    typedef T value_type;
+
+    std::size_t index;
+    T Record::* member;
+    T fallback;
+};
+
+template <class Record, class T>
+CSVColumn<Record, T> csvColumn(std::size_t index, T Record::* member, typename CSVColumn<Record, T>::value_type fallback = T())
+{
+    CSVColumn<Record, T> column = { index, member, fallback };
+    return column;
+}
+
+/**
+ * CSVSchema - a record type plus its column bindings, checked and
+ * expanded at compile time, so a row goes straight from the file into
+ * the record's fields:
+ *
+ *     struct cityRow { int zip; double lat; string_view city; };
+ *
+ *     const auto citySchema = csvSchema<cityRow>(
+ *         csvColumn(0, &cityRow::zip),
+ *         csvColumn(1, &cityRow::lat, 0.0),
+ *         csvColumn(3, &cityRow::city));
+ *
+ *     cityRow row;
+ *     while (reader.readNextRecord(citySchema, row)) ...
+ *
+ * string_view members point into the file (see CSVReader for how long
+ * they last). A row with fewer fields than the highest bound column is
+ * skipped rather than padded with defaults.
+ */
+template <class Record, class... Columns>
+class CSVSchema
+{
+    public:
+        typedef Record record_type;
+
+        CSVSchema(Columns... columns) : m_columns(columns...)
+        {
+            m_width = 0;
+            std::size_t indexes[] = { (columns.index + 1)... };
+            for (std::size_t i = 0; i < sizeof...(Columns); i++)
+            {
+                if (indexes[i] > m_width)
+                {
+                    m_width = indexes[i];
+                }
+            }
+        }
+
+        /**
+         * parse - fills a record from a split row
+         * Params:
+         *     const CSVRowView& row  - the row's fields
+         *     Record& out            - record to fill
+         * Returns
+         *     bool: false if the row is too short for the schema
+         */
+        bool parse(const CSVRowView& row, Record& out) const
+        {
+            if (row.size() < m_width)
+            {
+                return false;
+            }
+            std::apply([&](const Columns&... column) { (assign(row, out, column), ...); }, m_columns);
+            return true;
+        }
+
+        std::size_t width() const { return m_width; }
+
+    private:
+        template <class T>
+        static void assign(const CSVRowView& row, Record& out, const CSVColumn<Record, T>& column)
+        {
+            if (!csvConvert(row[column.index], out.*column.member))
+            {
+                out.*column.member = column.fallback;
+            }
+        }
+
+        std::tuple<Columns...> m_columns;
+        std::size_t m_width;
 };
 
+template <class Record, class... Columns>
+CSVSchema<Record, Columns...> csvSchema(Columns... columns)
+{
+    return CSVSchema<Record, Columns...>(columns...);
+}
@@ -4,6 +4,52 @@
 
 using namespace std;
 
+/**
+ * Edge colors are a small index into one palette, so an edge stays a few
+ * bytes with nothing to allocate. The names are only looked up when the
+ * graph is written out (colorName).
+ */
+enum edgeColor
+{
+    BLACK,
+    BLUE,
+    GREEN,
+    RED,
+    PURPLE,
+    ORANGE,
+    YELLOW,
+    BROWN,
+    PINK,
+    PALETTE_SIZE
+};
+
+const char *const PALETTE[PALETTE_SIZE] = {
+    "Black", "Blue", "Green", "Red", "Purple", "Orange", "Yellow", "Brown", "Pink"
+};
+
+/**
+ * colorName - name of a palette color ("" if it isn't one)
+ */
+inline const char *colorName(int color)
+{
+    return color >= 0 && color < PALETTE_SIZE ? PALETTE[color] : "";
+}
+
+/**
+ * colorByName - palette color with the given name (BLACK if none)
+ */
+inline edgeColor colorByName(const string &name)
+{
+    for (int c = 0; c < PALETTE_SIZE; c++)
+    {
+        if (name == PALETTE[c])
+        {
+            return (edgeColor)c;
+        }
+    }
+    return BLACK;
+}
+
 /**
  * edge - represents the edge of a graph.
  */
@@ -13,23 +59,23 @@ struct edge
     int toID;      // id of vertex edge is going to
     double weight; // weight of edge if any
     bool used;     // was edge used in some traversal
-    string color;
+    unsigned char color; // edgeColor
 
-    edge(int id, double w,string color="Black")
+    edge(int id, double w, edgeColor c = BLACK)
     {
         fromID = -1;
         toID = id;
         weight = w;
         used = false;
-        color = color;
+        color = (unsigned char)c;
     }
-    edge(int fid,int tid, double w,string color="Black")
+    edge(int fid,int tid, double w, edgeColor c = BLACK)
     {
         fromID = fid;
         toID = tid;
         weight = w;
         used = false;
-        color = color;
+        color = (unsigned char)c;
     }
     /**
      * operator<< - overload cout for edge
@@ -5,11 +5,24 @@
 #include <map>
 #include <iostream>
 #include <fstream>
+#include <sstream>
 #include <string>
 #include "edge_heap.h"
 #include "geo.h"
 #include "csv.h"
 #include <climits>
+#include <string_view>
+#include <thread>
+#include <deque>
+#include <cstdint>
+#include <cstring>
+#include <unordered_map>
+#include <filesystem>
+#include "mapped_file.h"
+#include "vertex_store.h"
+#include "kdtree.h"
+#include "grid_index.h"
+#include "rtree.h"
 
 using namespace std;
 
@@ -19,6 +32,128 @@ using namespace std;
 
 typedef map<int, int> intint;
 
+/**
+ * cityRecord - one row of a city file (zip,lat,lon,city,state,county),
+ * with the text pointing into the mapped file. Filled by citySchema in
+ * ingest.h, and used to hand batches of cities to addVertices.
+ */
+struct cityRecord
+{
+    int zip;
+    double lat;
+    double lon;
+    string_view city;
+    string_view state;
+    string_view county;
+};
+
+/**
+ * Snapshot file layout (see graph::saveSnapshot / loadSnapshot).
+ *
+ * A snapshot is a header followed by flat arrays of the structs below,
+ * each starting on an 8 byte boundary, so loading is a bounds check and
+ * a walk over the mapped arrays with nothing to parse. All text lives in
+ * one pool of chars that the other sections point into. A vertex's edges
+ * are stored together, in order, starting at firstEdge. Numbers are in
+ * the byte order of the machine that wrote the file; a file from a
+ * machine with the other byte order fails the byteOrder check.
+ *
+ * The header also records the size and modification time of the file the
+ * graph was built from (snapshotSourceStamp), so a snapshot can be
+ * refused once that file has changed.
+ */
+const char SNAPSHOT_MAGIC[4] = { 'G', 'S', 'N', 'P' };
+const uint32_t SNAPSHOT_VERSION = 2;
+const uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;
+
+struct snapshotString
+{
+    uint32_t offset; // into the string pool
+    uint32_t length;
+};
+
+struct snapshotSection
+{
+    uint64_t offset; // from the start of the file
+    uint64_t count;  // number of elements
+};
+
+struct snapshotHeader
+{
+    char magic[4];
+    uint32_t version;
+    uint32_t byteOrder;
+    int32_t nextID;           // graph::id
+    int64_t numEdges;         // graph::num_edges
+    uint64_t sourceSize;      // snapshotSourceStamp of the source file
+    int64_t sourceTime;
+    snapshotSection vertices; // snapshotVertex
+    snapshotSection edges;    // snapshotEdge
+    snapshotSection states;   // snapshotState
+    snapshotSection adjacent; // snapshotString, state names
+    snapshotSection stateCities; // int32_t, vertex IDs
+    snapshotSection pool;     // char
+};
+
+/**
+ * snapshotSourceStamp - size and modification time of a file, to tell
+ *     whether a snapshot's source has changed since it was written
+ * Params:
+ *     string filename: the file ("" = none: size and time are 0)
+ *     uint64_t& size, int64_t& time: the stamp (a missing file gets size
+ *                                    UINT64_MAX)
+ */
+inline void snapshotSourceStamp(string filename, uint64_t &size, int64_t &time)
+{
+    error_code ec;
+
+    size = 0;
+    time = 0;
+    if (filename.empty())
+    {
+        return;
+    }
+    size = filesystem::file_size(filename, ec);
+    if (ec)
+    {
+        size = UINT64_MAX;
+        return;
+    }
+    time = (int64_t)filesystem::last_write_time(filename, ec).time_since_epoch().count();
+}
+
+struct snapshotVertex
+{
+    snapshotString city;
+    snapshotString state;
+    double lat;
+    double lon;
+    uint32_t firstEdge;
+    uint32_t edgeCount;
+    uint32_t visited;
+    uint32_t reserved;
+};
+
+struct snapshotEdge
+{
+    int32_t fromID;
+    int32_t toID;
+    double weight;
+    snapshotString color; // palette name (colorName)
+    uint32_t used;
+    uint32_t reserved;
+};
+
+// one key of mapAdjList / cityByState
+struct snapshotState
+{
+    snapshotString name;
+    uint32_t firstAdjacent;
+    uint32_t adjacentCount;
+    uint32_t firstCity;
+    uint32_t cityCount;
+};
+
 /**
  * vertex - represents a vertex in a graph.
  */
@@ -146,10 +281,13 @@ class graph
     int id;                      // id counter for new vertices
     int num_edges;               // edge count
     vector<vertex *> vertexList; // vector to hold vertices
+    vertexStore vertexData;      // the same vertices as flat arrays, for distance loops
+    kdTree spatial;              // nearest neighbor index, see spatialIndex()
+    gridIndex cells;             // radius / box index, see cellIndex()
+    rTree regions;               // viewport index, see regionIndex()
 	map<string, int> cityLookup;        // dictionary of unique cities
     llBox box;                   // bounding box of coords
     edgePriorityList *E;
-    string *colors;
 	map<string, vector <string> > mapAdjList;
 	map<string, vector <int> > cityByState;
 
@@ -164,24 +302,119 @@ class graph
         return new vertex(id++, city, state, ll);
     }
 
+    /**
+     * spatialIndex - the k-d tree over the vertices, rebuilt first if
+     *     vertexData has changed since it was last built (added, moved or
+     *     replaced vertices: see vertexStore::generation)
+     * Returns:
+     *     kdTree&
+     */
+    kdTree &spatialIndex()
+    {
+        if (!spatial.isCurrent(vertexData))
+        {
+            spatial.build(vertexData);
+        }
+        return spatial;
+    }
+
+    /**
+     * cellIndex - the grid cell index over the vertices, rebuilt first if
+     *     vertexData has changed since it was last built
+     * Returns:
+     *     gridIndex&
+     */
+    gridIndex &cellIndex()
+    {
+        if (!cells.isCurrent(vertexData))
+        {
+            cells.build(vertexData);
+        }
+        return cells;
+    }
+
+    // true if edge e of vertex v is its first edge to that neighbor
+    bool firstEdgeTo(size_t v, size_t e)
+    {
+        for (size_t i = 0; i < e; i++)
+        {
+            if (vertexList[v]->E[i].toID == vertexList[v]->E[e].toID)
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * regionIndex - the R-tree over the vertices and edges, bulk loaded the
+     *     first time it is asked for. From then on addVertex, addVertices
+     *     and addEdge insert into it as they go; moving vertices drops it
+     *     until it is asked for again.
+     * Returns:
+     *     rTree&
+     */
+    rTree &regionIndex()
+    {
+        if (!regions.isBuilt())
+        {
+            vector<pair<int, int> > segments;
+            for (size_t v = 0; v < vertexList.size(); v++)
+            {
+                for (size_t e = 0; e < vertexList[v]->E.size(); e++)
+                {
+                    int w = vertexList[v]->E[e].toID;
+                    // one segment per connected pair: the first edge from
+                    // the lower ID, or from v if w has none back
+                    if (w == (int)v || !firstEdgeTo(v, e))
+                    {
+                        continue;
+                    }
+                    if (w > (int)v || !vertexList[w]->Neighbors((int)v))
+                    {
+                        segments.push_back(make_pair((int)v, w));
+                    }
+                }
+            }
+            regions.build(vertexData, segments);
+        }
+        return regions;
+    }
+
     /**
      * Constructor
      */
     graph()
+    {
+        init();
+		stateAdjList();
+    }
+
+    /**
+     * Constructor
+     * Params:
+     *     string snapshot: snapshot file to load (see loadSnapshot). If it
+     *                      can't be loaded the graph starts out empty, with
+     *                      the state maps read from the text files.
+     *     string source: file the snapshot was built from; if it has
+     *                    changed since, the snapshot isn't loaded
+     */
+    explicit graph(string snapshot, string source = "")
+    {
+        init();
+        if (!loadSnapshot(snapshot, source))
+        {
+            stateAdjList();
+        }
+    }
+
+    /**
+     * init - sets up an empty graph (without the state maps)
+     */
+    void init()
     {
         id = 0;
         num_edges = 0;
-		stateAdjList();
-        colors = new string[9];
-        colors[0] = "Black";
-        colors[1] = "Blue";
-        colors[2] = "Green";
-        colors[3] = "Red";
-        colors[4] = "Purple";
-        colors[5] = "Orange";
-        colors[6] = "Yellow";
-        colors[7] = "Brown";
-        colors[8] = "Pink";
     }
 
     /**
@@ -194,6 +427,7 @@ class graph
         id = G.id;
         num_edges = G.num_edges;
         vertexList = G.vertexList;
+        vertexData = G.vertexData;
         cityLookup = G.cityLookup;
 		mapAdjList = G.mapAdjList;
 		cityByState = G.cityByState;
@@ -217,11 +451,63 @@ class graph
 
         vertex *temp = createVertex(city, state, latlon(lat, lon));
         vertexList.push_back(temp);
+        vertexData.add(city, state, lat, lon);
+        regions.insertVertex(temp->ID, lat, lon);
 
         //update the value that city points to.
         return temp->ID;
     }
 
+    /**
+     * addVertices - adds a batch of vertices. Same result as calling
+     *     addVertex on each record in order (IDs are handed out in batch
+     *     order), but the vertex objects are built on several threads.
+     * Params:
+     *     vector<cityRecord> batch  - cities to add, in ID order
+     *     int              threads  - threads to build them with
+     * Returns
+     *     int: ID of the first vertex added
+     */
+    int addVertices(const vector<cityRecord> &batch, int threads = 1)
+    {
+        int first = id;
+        size_t base = vertexList.size();
+
+        vertexList.resize(base + batch.size());
+        id += (int)batch.size();
+
+        if (threads < 1)
+        {
+            threads = 1;
+        }
+
+        vector<thread> pool;
+        for (int t = 0; t < threads; t++)
+        {
+            pool.push_back(thread([&, t]() {
+                size_t from = batch.size() * t / threads;
+                size_t to = batch.size() * (t + 1) / threads;
+                for (size_t i = from; i < to; i++)
+                {
+                    const cityRecord &r = batch[i];
+                    vertexList[base + i] = new vertex(first + (int)i, string(r.city), string(r.state), latlon(r.lat, r.lon));
+                }
+            }));
+        }
+        for (int t = 0; t < threads; t++)
+        {
+            pool[t].join();
+        }
+
+        for (size_t i = 0; i < batch.size(); i++)
+        {
+            box.addLatLon(latlon(batch[i].lat, batch[i].lon));
+            vertexData.add(batch[i].city, batch[i].state, batch[i].lat, batch[i].lon);
+            regions.insertVertex(first + (int)i, batch[i].lat, batch[i].lon);
+        }
+        return first;
+    }
+
     /**
      * Method: getVertex
      * Params:
@@ -292,8 +578,14 @@ class graph
      * Returns 
      *     void
      */
-    void addEdge(int fromID, int toID, double weight = 0, bool directed = false, string color = "Black")
+    void addEdge(int fromID, int toID, double weight = 0, bool directed = false, edgeColor color = BLACK)
     {
+        if (regions.isBuilt() && fromID != toID && !vertexList[fromID]->Neighbors(toID) &&
+            !vertexList[toID]->Neighbors(fromID))
+        {
+            regions.insertEdge(fromID, toID, vertexData.lat[fromID], vertexData.lon[fromID], vertexData.lat[toID], vertexData.lon[toID]);
+        }
+
         edge e1(fromID, toID, weight, color);
         vertexList[fromID]->E.push_back(e1);
         num_edges++;
@@ -321,7 +613,7 @@ class graph
      * Returns:
      *     void
      */
-    //void addEdge(string fromCity, string toCity, double weight = 0, bool directed = false, string color = "Black")
+    //void addEdge(string fromCity, string toCity, double weight = 0, bool directed = false, edgeColor color = BLACK)
 
     /**
      * printGraph - prints the graph out for debugging purposes
@@ -340,6 +632,7 @@ class graph
             double brng = bearing((*(*vit)).loc, box.center);
 
             (*(*vit)).update(geo_destination((*(*vit)).loc, 100, brng));
+            vertexData.move((*vit)->ID, (*vit)->loc.lat, (*vit)->loc.lon);
             cout << (*(*vit)) << endl;
 
             if ((*vit)->E.size() > 0)
@@ -350,6 +643,7 @@ class graph
                 }
             }
         }
+        regions.clear();
     }
     /**
      * magickGraph - instance of drawGraph included from mymagick.h
@@ -420,10 +714,10 @@ class graph
                     //     cout << "stupid color: " << (*eit).color << endl;
                     //     if ((*eit).color == "")
                     //     {
-                    (*eit).color = colors[rand() % 9];
+                    (*eit).color = rand() % PALETTE_SIZE;
                     //     }
 
-                    dg.drawLine(xy1.x, xy1.y, xy2.x, xy2.y, (*eit).color);
+                    dg.drawLine(xy1.x, xy1.y, xy2.x, xy2.y, colorName((*eit).color));
                     //     cout << rx << "," << ry << "," << x2 << "," << y2 << endl;
                     // }
                 }
@@ -485,11 +779,13 @@ class graph
 
             //update the vertex's location
             (*(*vit)).update(destination);
+            vertexData.move((*vit)->ID, destination.lat, destination.lon);
 
             //update the bounding box I keep track of
             //encompassing the points in the graph
             box.addLatLon(destination);
         }
+        regions.clear();
     }
 
     string mylower(string s)
@@ -521,52 +817,58 @@ class graph
         return "";
     }
 
+    /**
+     * createSpanningTree - keeps joining cities to their closest city not
+     *     yet connected, going round the vertex list, until every city has
+     *     an edge
+     * Params:
+     *     string: unused
+     */
     void createSpanningTree(string   = "")
     {
-        vector<vertex *>::iterator i;
-        vector<vertex *>::iterator j;
-        vector<edge>::iterator eit;
-        edgeHeap E;
-        edge *e;
-        vertex *ftemp;
-        vertex *ttemp;
-        vertex *current;
-
-        double distance = 0;
-        double d = 0;
-        double minDistance = FLT_MAX;
-        int closestID;
+        kdTree &near = spatialIndex();
+        kdTree open = near; // unvisited cities only
         int count = 0;
-        int ecount = 0;
-        string minCity;
-        int c;
+        int edgeless = 0;
+        int idle = 0; // cities looked at since the last edge went in
+        int c = 0;
 
-        c = 0;
+        for (size_t v = 0; v < vertexList.size(); v++)
+        {
+            if (vertexList[v]->E.size() == 0)
+            {
+                edgeless++;
+            }
+            if (vertexList[v]->visited)
+            {
+                open.remove((int)v);
+            }
+        }
 
-        while (!Connected())
+        while (edgeless > 0 && idle <= (int)vertexList.size())
         {
             cout << "Connecting: " << vertexList[c]->city << endl;
-            // Inner loop through vertices finds closes neighbors
-            for (j = vertexList.begin(); j != vertexList.end(); j++)
-            {
-                if ((*j)->visited == false)
-                {
-                    distance = distanceEarth(vertexList[c]->loc.lat, vertexList[c]->loc.lon, (*j)->loc.lat, (*j)->loc.lon);
 
-                    if (distance > 0)
-                    {
-                        E.Insert(new edge(vertexList[c]->ID, (*j)->ID, distance, colors[rand() % 9]));
-                    }
-                }
+            vector<int> closest = open.kNearestIf(c, 1, [&](int v) { return vertexData.distance(c, v, CHORD2) > 0; });
+            if (closest.empty() && vertexList[c]->E.size() == 0)
+            {
+                // everything else is connected: join the closest city of all
+                closest = near.kNearestIf(c, 1, [&](int v) { return vertexData.distance(c, v, CHORD2) > 0; });
             }
 
-            e = E.Extract();
-
-            addEdge(e->fromID, e->toID, e->weight, false, colors[count % 9]);
-            vertexList[e->fromID]->visited = true;
-            vertexList[e->toID]->visited = true;
+            idle++;
+            if (!closest.empty())
+            {
+                int to = closest[0];
+                edgeless -= (vertexList[c]->E.size() == 0) + (vertexList[to]->E.size() == 0);
+                addEdge(c, to, vertexData.distance(c, to), false, (edgeColor)(count % PALETTE_SIZE));
+                vertexList[c]->visited = true;
+                vertexList[to]->visited = true;
+                open.remove(c);
+                open.remove(to);
+                idle = 0;
+            }
 
-            E.ClearHeap();
             c++;
             if (c == vertexList.size())
             {
@@ -576,223 +878,192 @@ class graph
         }
     }
 
+    /**
+     * OLDcreateForest - joins every city to its closest unvisited city
+     */
     void OLDcreateForest()
     {
-        E = new edgePriorityList[vertexList.size()];
-        edge *e;
+        kdTree open = spatialIndex(); // unvisited cities only
+        vector<int> closest(vertexList.size(), -1);
 
-        double distance = 0;
-        double minDistance = FLT_MAX;
+        for (size_t v = 0; v < vertexList.size(); v++)
+        {
+            if (vertexList[v]->visited)
+            {
+                open.remove((int)v);
+            }
+        }
 
-        // for every vertex, find its closest neighbors and push on its list
+        // for every vertex, find its closest neighbor
         for (int v1 = 0; v1 < vertexList.size(); v1++)
         {
             cout << "Progress : " << v1 << " / " << vertexList.size() << endl;
 
-            // Inner loop through vertices finds closes neighbors
-            for (int v2 = 0; v2 < vertexList.size(); v2++)
+            vector<int> found = open.kNearestIf(v1, 1, [&](int v2) { return vertexData.distance(v1, v2, CHORD2) > 0; });
+            if (!found.empty())
             {
-                if (vertexList[v2]->visited == false)
-                {
-                    distance = distanceEarth(vertexList[v1]->loc.lat, vertexList[v1]->loc.lon, vertexList[v2]->loc.lat, vertexList[v2]->loc.lon);
-
-                    if (distance > 0)
-                    {
-                        // add edge to vertex: c's priority queue
-                        // closest edge to "c" in front of list
-                        E[v1].Insert(new edge(vertexList[v1]->ID, vertexList[v2]->ID, distance, "Pink"));
-                    }
-                }
+                closest[v1] = found[0];
             }
         }
 
         // Connect close neighbors and create a disconnected forest
-        // using the priority queue's for each vertex
         for (int v = 0; v < vertexList.size(); v++)
         {
-            e = E[v].Pop();
-
-            e->color = "Green";
+            if (closest[v] < 0)
+            {
+                continue;
+            }
+            double weight = vertexData.distance(v, closest[v]);
 
-            cout << "edge weight: " << e->weight << endl;
+            cout << "edge weight: " << weight << endl;
 
-            addEdge(e->fromID, e->toID, e->weight, false, "Green");
+            addEdge(v, closest[v], weight, false, GREEN);
         }
-
-        for (int v = 0; v < vertexList.size(); v++)
-        {
-            E[v].ClearList();
-        }
-        delete E;
     }
 
+	/**
+	 * createForest - walks out from a city breadth first, giving each city
+	 *     it reaches its closest neighbors (createForest2). When a walk runs
+	 *     out, the next one starts at the first city not reached yet.
+	 * Params:
+	 *     string startingCity: city to start from
+	 */
 	void createForest(string startingCity)
 	{
+		if (vertexList.empty())
+		{
+			return;
+		}
+
 		int startingID = cityLookup[startingCity];
-		createForest2(startingID);
-		vector <int> next = { vertexList[startingID]->E[0].toID, vertexList[startingID]->E[1].toID, vertexList[startingID]->E[2].toID };
-		vertexList[startingID]->visited = true;
-		while (!AllVisited())
+		int unvisited = 0;
+		int scan = 0;
+		deque<int> next;
+		kdTree open = spatialIndex(); // cities with fewer than 3 edges
+
+		for (size_t v = 0; v < vertexList.size(); v++)
 		{
-			if (vertexList[next[0]]->visited != true)
+			if (!vertexList[v]->visited)
 			{
-				next.push_back(createForest2(next[0]));
-				next.pop_back();
+				unvisited++;
 			}
-			for (int n1 = 0; n1 < 3; n1++)
-				next.push_back(vertexList[next[0]]->E[n1].toID);
-			next.erase(next.begin());
-			if (next.size() == 0)
+			if (vertexList[v]->E.size() >= 3)
 			{
-				int newID = 0;
-				while (vertexList[newID]->visited == true)
-					newID++;
-				next.push_back(newID);
+				open.remove((int)v);
 			}
 		}
-	}
 
-	int createForest2(int startingID)
-	{
-		double distance = 0;
-		double distArray[3][2] = { 0 };
-
-		for (int v1 = 0; v1 < cityByState[vertexList[startingID]->state].size(); v1++)
+		next.push_back(startingID);
+		while (unvisited > 0)
 		{
-			if (vertexList[startingID]->E.size() < 3 && vertexList[cityByState[vertexList[startingID]->state][v1]]->E.size() < 3)
+			if (next.empty())
 			{
-				distance = distanceEarth(vertexList[startingID]->loc.lat, vertexList[startingID]->loc.lon, vertexList[cityByState[vertexList[startingID]->state][v1]]->loc.lat, vertexList[cityByState[vertexList[startingID]->state][v1]]->loc.lon);
-				if (distance < distArray[0][0] || distArray[0][0] == 0)
+				while (vertexList[scan]->visited)
 				{
-					distArray[0][0] = distance;
-					distArray[0][1] = vertexList[cityByState[vertexList[startingID]->state][v1]]->ID;
+					scan++;
 				}
-				else if (distance < distArray[1][0] || distArray[1][0] == 0)
-				{
-					distArray[1][0] = distance;
-					distArray[1][1] = vertexList[cityByState[vertexList[startingID]->state][v1]]->ID;
-				}
-				else if (distance < distArray[2][0] || distArray[2][0] == 0)
+				next.push_back(scan);
+			}
+
+			int v = next.front();
+			next.pop_front();
+			if (vertexList[v]->visited)
+			{
+				continue;
+			}
+
+			createForest2(v, &open);
+			vertexList[v]->visited = true;
+			unvisited--;
+
+			for (size_t e = 0; e < vertexList[v]->E.size(); e++)
+			{
+				if (!vertexList[vertexList[v]->E[e].toID]->visited)
 				{
-					distArray[2][0] = distance;
-					distArray[2][1] = vertexList[cityByState[vertexList[startingID]->state][v1]]->ID;
+					next.push_back(vertexList[v]->E[e].toID);
 				}
 			}
 		}
-		if (distArray[0][0] != 0 && distArray[1][0] != 0 && distArray[2][0] != 0)
+	}
+
+	/**
+	 * createForest2 - connects a city to its closest cities that have fewer
+	 *     than 3 edges, until it has 3 edges itself. The k-d tree finds
+	 *     them directly, instead of scanning the city's state and then
+	 *     neighboring states (mapAdjList) one at a time.
+	 * Params:
+	 *     int startingID: city to connect
+	 *     kdTree* open: if given, searched instead of spatialIndex(): a copy
+	 *                   of it with the cities that have 3 edges removed.
+	 *                   Cities that fill up here are removed from it too, so
+	 *                   a caller connecting city after city (createForest)
+	 *                   doesn't search through more and more full ones.
+	 * Returns:
+	 *     int: startingID
+	 */
+	int createForest2(int startingID, kdTree *open = NULL)
+	{
+		int wanted = 3 - (int)vertexList[startingID]->E.size();
+		kdTree &near = open ? *open : spatialIndex();
+
+		if (wanted <= 0)
 		{
-			for (int a2 = 0; a2 < 3; a2++)
-			{
-				addEdge(startingID, distArray[a2][1], distArray[a2][0], false, "Green");
-			}
 			return startingID;
 		}
-		else
+
+		vector<int> closest = near.kNearestIf(startingID, wanted, [&](int v) {
+			return vertexList[v]->E.size() < 3 && !vertexList[startingID]->Neighbors(v) &&
+				vertexData.distance(startingID, v, CHORD2) > 0;
+		});
+		for (size_t i = 0; i < closest.size(); i++)
+		{
+			addEdge(startingID, closest[i], vertexData.distance(startingID, closest[i]), false, GREEN);
+			if (open && vertexList[closest[i]]->E.size() >= 3)
 			{
-				vector <string> toVisit;
-				vector <string> visited;
-				visited.push_back(vertexList[startingID]->state);
-				for (int t1 = 1; t1 < mapAdjList[vertexList[startingID]->state].size(); t1++)
-					toVisit.push_back(mapAdjList[vertexList[startingID]->state][t1]);
-				int stateCount = 0;
-				string currentState = toVisit[0];
-				while (distArray[2][0] == 0)
-				{
-					if (stateCount >= mapAdjList[currentState].size())
-						stateCount = 0;
-					if (stateCount == mapAdjList[currentState].size() - 1)
-					{
-						visited.push_back(currentState);
-						for (int w1 = 0; w1 < visited.size(); w1++)
-							for (int w2 = 0; w2 < toVisit.size(); w2++)
-								if (toVisit[w1] == visited[w2])
-									toVisit.erase(toVisit.begin() + w1);
-						if (toVisit.size() != 0)
-							currentState = toVisit[0];
-						else
-						{
-							for (int a2 = 0; a2 < vertexList[startingID]->E.size(); a2++)
-							{
-								addEdge(startingID, distArray[a2][1], distArray[a2][0], false, "Green");
-							}
-							return startingID;
-						}
-						for (int t1 = 1; t1 < mapAdjList[currentState].size(); t1++)
-							toVisit.push_back(mapAdjList[currentState][t1]);
-					}
-					for (int v2 = 0; v2 < cityByState[currentState].size(); v2++)
-					{
-						if (vertexList[startingID]->E.size() < 3 && vertexList[cityByState[currentState][v2]]->E.size() < 3)
-						{
-							distance = distanceEarth(vertexList[startingID]->loc.lat, vertexList[startingID]->loc.lon, vertexList[cityByState[currentState][v2]]->loc.lat, vertexList[cityByState[currentState][v2]]->loc.lon);
-							if (distance < distArray[0][0] || distArray[0][0] == 0)
-							{
-								distArray[0][0] = distance;
-								distArray[0][1] = vertexList[cityByState[vertexList[startingID]->state][v2]]->ID;
-							}
-							else if (distance < distArray[1][0] || distArray[1][0] == 0)
-							{
-								distArray[1][0] = distance;
-								distArray[1][1] = vertexList[cityByState[vertexList[startingID]->state][v2]]->ID;
-							}
-							else if (distance < distArray[2][0] || distArray[2][0] == 0)
-							{
-								distArray[2][0] = distance;
-								distArray[2][1] = vertexList[cityByState[vertexList[startingID]->state][v2]]->ID;
-							}
-						}
-					}
-					stateCount++;
-				}
-				for (int a3 = 0; a3 < 3; a3++)
-				{
-					addEdge(startingID, distArray[a3][1], distArray[a3][0], false, "Green");
-				}
-				return startingID;
+				open->remove(closest[i]);
 			}
 		}
+		if (open && vertexList[startingID]->E.size() >= 3)
+		{
+			open->remove(startingID);
+		}
+		return startingID;
+	}
 
+		/**
+		 * connectForest - joins every city to its closest city that isn't
+		 *     already its neighbor
+		 */
 		void connectForest()
 		{
-			bool neighbor;
-			double distance;
-			edge *e;
+			kdTree &near = spatialIndex();
+			vector<int> closest(vertexList.size(), -1);
 
-			E = new edgePriorityList[vertexList.size()];
-
-			// for every vertex, find its non neighbor
+			// for every vertex, find its closest non neighbor
 			for (int v1 = 0; v1 < vertexList.size(); v1++)
 			{
-				// Inner loop through vertices finds closes non neighbors
-				for (int v2 = 0; v2 < vertexList.size(); v2++)
+				vector<int> found = near.kNearestIf(v1, 1, [&](int v2) {
+					return !vertexList[v1]->Neighbors(v2) && vertexData.distance(v1, v2, CHORD2) > 0;
+				});
+				if (!found.empty())
 				{
-					neighbor = vertexList[v1]->Neighbors(vertexList[v2]->ID);
-					cout << "neighbor: " << neighbor << endl;
-					if (!neighbor)
-					{
-						distance = distanceEarth(vertexList[v1]->loc.lat, vertexList[v1]->loc.lon, vertexList[v2]->loc.lat, vertexList[v2]->loc.lon);
-
-						if (distance > 0)
-						{
-							// add edge to vertex: c's priority queue
-							// closest edge to "v1" that is a non-neighbor
-							E[v1].Insert(new edge(vertexList[v1]->ID, vertexList[v2]->ID, distance, "Purple"));
-						}
-					}
+					closest[v1] = found[0];
 				}
 			}
 
 			// Connect close neighbors and create a disconnected forest
-			// using the priority queue's for each vertex
 			for (int v = 0; v < vertexList.size(); v++)
 			{
-				e = E[v].Pop();
-				e->color = "Orange";
+				if (closest[v] < 0)
+				{
+					continue;
+				}
+				double weight = vertexData.distance(v, closest[v]);
 
-				cout << "edge weight: " << e->weight << endl;
-				cout << "edge color:  " << e->color << endl;
+				cout << "edge weight: " << weight << endl;
+				cout << "edge color:  " << colorName(ORANGE) << endl;
 
-				addEdge(e->fromID, e->toID, e->weight, false, "Orange");
+				addEdge(v, closest[v], weight, false, ORANGE);
 			}
 		}
 
@@ -917,7 +1188,9 @@ class graph
 		{
 			// do the copy
 			vertexList = g.vertexList;
+			vertexData = g.vertexData;
 			id = g.id;
+			regions.clear();
 
 			// return the existing object so we can chain this operator
 			return *this;
@@ -965,6 +1238,313 @@ class graph
 			infile.close();
 		}
 
+		/**
+		 * saveSnapshot - writes the vertices, their edges and the state maps
+		 *     to a binary snapshot that loadSnapshot can map back in
+		 *     (layout above snapshotHeader)
+		 * Params:
+		 *     string filename: file to write
+		 *     string source: file the graph was built from, stamped into
+		 *                    the header for loadSnapshot to check
+		 * Returns:
+		 *     bool: false if the file could not be written
+		 */
+		bool saveSnapshot(string filename, string source = "")
+		{
+			snapshotHeader header;
+			vector<snapshotVertex> vertices(vertexList.size());
+			vector<snapshotEdge> edges;
+			vector<snapshotState> states;
+			vector<snapshotString> adjacent;
+			vector<int32_t> stateCities;
+			string pool;
+			unordered_map<string, snapshotString> interned;
+
+			// every distinct string is stored once
+			auto intern = [&](const string &text) {
+				unordered_map<string, snapshotString>::iterator found = interned.find(text);
+				if (found != interned.end())
+				{
+					return found->second;
+				}
+				snapshotString ref = { (uint32_t)pool.size(), (uint32_t)text.size() };
+				pool += text;
+				interned[text] = ref;
+				return ref;
+			};
+
+			for (size_t v = 0; v < vertexList.size(); v++)
+			{
+				vertex *vp = vertexList[v];
+				snapshotVertex &sv = vertices[v];
+
+				memset(&sv, 0, sizeof(sv));
+				sv.city = intern(vp->city);
+				sv.state = intern(vp->state);
+				sv.lat = vp->loc.lat;
+				sv.lon = vp->loc.lon;
+				sv.firstEdge = (uint32_t)edges.size();
+				sv.edgeCount = (uint32_t)vp->E.size();
+				sv.visited = vp->visited;
+
+				for (size_t e = 0; e < vp->E.size(); e++)
+				{
+					snapshotEdge se;
+					memset(&se, 0, sizeof(se));
+					se.fromID = vp->E[e].fromID;
+					se.toID = vp->E[e].toID;
+					se.weight = vp->E[e].weight;
+					se.color = intern(colorName(vp->E[e].color));
+					se.used = vp->E[e].used;
+					edges.push_back(se);
+				}
+			}
+
+			// the union of the keys of both state maps
+			map<string, int> stateNames;
+			for (map<string, vector<string> >::iterator it = mapAdjList.begin(); it != mapAdjList.end(); it++)
+			{
+				stateNames[it->first] = 0;
+			}
+			for (map<string, vector<int> >::iterator it = cityByState.begin(); it != cityByState.end(); it++)
+			{
+				stateNames[it->first] = 0;
+			}
+			for (map<string, int>::iterator it = stateNames.begin(); it != stateNames.end(); it++)
+			{
+				snapshotState ss;
+				memset(&ss, 0, sizeof(ss));
+				ss.name = intern(it->first);
+				ss.firstAdjacent = (uint32_t)adjacent.size();
+				ss.firstCity = (uint32_t)stateCities.size();
+
+				map<string, vector<string> >::iterator adj = mapAdjList.find(it->first);
+				if (adj != mapAdjList.end())
+				{
+					for (size_t a = 0; a < adj->second.size(); a++)
+					{
+						adjacent.push_back(intern(adj->second[a]));
+					}
+				}
+				map<string, vector<int> >::iterator cities = cityByState.find(it->first);
+				if (cities != cityByState.end())
+				{
+					stateCities.insert(stateCities.end(), cities->second.begin(), cities->second.end());
+				}
+				ss.adjacentCount = (uint32_t)adjacent.size() - ss.firstAdjacent;
+				ss.cityCount = (uint32_t)stateCities.size() - ss.firstCity;
+				states.push_back(ss);
+			}
+
+			if (pool.size() > UINT32_MAX || edges.size() > UINT32_MAX)
+			{
+				return false;
+			}
+
+			memset(&header, 0, sizeof(header));
+			memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+			header.version = SNAPSHOT_VERSION;
+			header.byteOrder = SNAPSHOT_BYTE_ORDER;
+			header.nextID = id;
+			header.numEdges = num_edges;
+			snapshotSourceStamp(source, header.sourceSize, header.sourceTime);
+
+			uint64_t offset = sizeof(header);
+			auto place = [&](snapshotSection &section, size_t count, size_t size) {
+				offset = (offset + 7) & ~(uint64_t)7;
+				section.offset = offset;
+				section.count = count;
+				offset += (uint64_t)count * size;
+			};
+			place(header.vertices, vertices.size(), sizeof(snapshotVertex));
+			place(header.edges, edges.size(), sizeof(snapshotEdge));
+			place(header.states, states.size(), sizeof(snapshotState));
+			place(header.adjacent, adjacent.size(), sizeof(snapshotString));
+			place(header.stateCities, stateCities.size(), sizeof(int32_t));
+			place(header.pool, pool.size(), 1);
+
+			ofstream out(filename, ios::binary);
+			uint64_t written = 0;
+			auto write = [&](const snapshotSection &section, const void *data, size_t bytes) {
+				static const char zeros[8] = { 0 };
+				out.write(zeros, (streamsize)(section.offset - written));
+				out.write((const char *)data, (streamsize)bytes);
+				written = section.offset + bytes;
+			};
+
+			out.write((const char *)&header, sizeof(header));
+			written = sizeof(header);
+			write(header.vertices, vertices.data(), vertices.size() * sizeof(snapshotVertex));
+			write(header.edges, edges.data(), edges.size() * sizeof(snapshotEdge));
+			write(header.states, states.data(), states.size() * sizeof(snapshotState));
+			write(header.adjacent, adjacent.data(), adjacent.size() * sizeof(snapshotString));
+			write(header.stateCities, stateCities.data(), stateCities.size() * sizeof(int32_t));
+			write(header.pool, pool.data(), pool.size());
+			return out.good();
+		}
+
+		/**
+		 * loadSnapshot - replaces the graph with one saved by saveSnapshot.
+		 *     The file is mapped and its arrays are read in place; every
+		 *     offset in it is checked before it is used, so a truncated or
+		 *     corrupt file is rejected rather than read past. cityLookup is
+		 *     rebuilt from the vertices, as lookupHelp would.
+		 * Params:
+		 *     string filename: snapshot to load
+		 *     string source: file the snapshot should have been built
+		 *                    from ("" = don't check); a snapshot saved
+		 *                    before that file last changed is refused
+		 * Returns:
+		 *     bool: false (and the graph unchanged) if the file could not
+		 *           be loaded
+		 */
+		bool loadSnapshot(string filename, string source = "")
+		{
+			MappedFile file(filename);
+			const char *data = file.data();
+			uint64_t size = file.size();
+
+			if (!file.good() || size < sizeof(snapshotHeader))
+			{
+				return false;
+			}
+
+			snapshotHeader header;
+			memcpy(&header, data, sizeof(header));
+			if (memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic)) != 0 ||
+				header.version != SNAPSHOT_VERSION || header.byteOrder != SNAPSHOT_BYTE_ORDER)
+			{
+				return false;
+			}
+
+			uint64_t sourceSize;
+			int64_t sourceTime;
+			snapshotSourceStamp(source, sourceSize, sourceTime);
+			if (!source.empty() && (header.sourceSize != sourceSize || header.sourceTime != sourceTime))
+			{
+				return false;
+			}
+
+			auto fits = [&](const snapshotSection &section, size_t elementSize) {
+				return section.offset % 8 == 0 && section.offset <= size &&
+					section.count <= (size - section.offset) / elementSize;
+			};
+			if (!fits(header.vertices, sizeof(snapshotVertex)) || !fits(header.edges, sizeof(snapshotEdge)) ||
+				!fits(header.states, sizeof(snapshotState)) || !fits(header.adjacent, sizeof(snapshotString)) ||
+				!fits(header.stateCities, sizeof(int32_t)) || !fits(header.pool, 1) ||
+				header.vertices.count > INT_MAX || header.nextID < (int64_t)header.vertices.count)
+			{
+				return false;
+			}
+
+			const snapshotVertex *vertices = (const snapshotVertex *)(data + header.vertices.offset);
+			const snapshotEdge *edges = (const snapshotEdge *)(data + header.edges.offset);
+			const snapshotState *states = (const snapshotState *)(data + header.states.offset);
+			const snapshotString *adjacent = (const snapshotString *)(data + header.adjacent.offset);
+			const int32_t *stateCities = (const int32_t *)(data + header.stateCities.offset);
+			const char *pool = data + header.pool.offset;
+			uint64_t vertexCount = header.vertices.count;
+
+			auto text = [&](const snapshotString &ref, string &out) {
+				if (ref.offset > header.pool.count || ref.length > header.pool.count - ref.offset)
+				{
+					return false;
+				}
+				out.assign(pool + ref.offset, ref.length);
+				return true;
+			};
+			auto range = [](uint64_t first, uint64_t count, uint64_t total) {
+				return first <= total && count <= total - first;
+			};
+			auto isVertex = [&](int32_t v) {
+				return v >= 0 && (uint64_t)v < vertexCount;
+			};
+
+			// build everything aside, so a bad file leaves the graph alone
+			vector<vertex *> newVertices;
+			map<string, vector<string> > newAdjList;
+			map<string, vector<int> > newByState;
+			bool ok = true;
+			string city, state, color;
+
+			newVertices.reserve((size_t)vertexCount);
+			for (uint64_t v = 0; v < vertexCount && ok; v++)
+			{
+				const snapshotVertex &sv = vertices[v];
+				ok = text(sv.city, city) && text(sv.state, state) && range(sv.firstEdge, sv.edgeCount, header.edges.count);
+				if (!ok)
+				{
+					break;
+				}
+
+				vertex *vp = new vertex((int)v, city, state, latlon(sv.lat, sv.lon));
+				vp->visited = sv.visited != 0;
+				vp->E.reserve(sv.edgeCount);
+				for (uint64_t e = sv.firstEdge; e < (uint64_t)sv.firstEdge + sv.edgeCount && ok; e++)
+				{
+					const snapshotEdge &se = edges[e];
+					ok = isVertex(se.toID) && (se.fromID < 0 || isVertex(se.fromID)) && text(se.color, color);
+					if (ok)
+					{
+						vp->E.push_back(edge(se.fromID, se.toID, se.weight, colorByName(color)));
+						vp->E.back().used = se.used != 0;
+					}
+				}
+				newVertices.push_back(vp);
+			}
+
+			for (uint64_t s = 0; s < header.states.count && ok; s++)
+			{
+				const snapshotState &ss = states[s];
+				ok = text(ss.name, state) && range(ss.firstAdjacent, ss.adjacentCount, header.adjacent.count) &&
+					range(ss.firstCity, ss.cityCount, header.stateCities.count);
+				if (!ok)
+				{
+					break;
+				}
+
+				vector<string> &adj = newAdjList[state];
+				for (uint64_t a = ss.firstAdjacent; a < (uint64_t)ss.firstAdjacent + ss.adjacentCount && ok; a++)
+				{
+					ok = text(adjacent[a], city);
+					adj.push_back(city);
+				}
+				vector<int> &cities = newByState[state];
+				for (uint64_t c = ss.firstCity; c < (uint64_t)ss.firstCity + ss.cityCount && ok; c++)
+				{
+					ok = isVertex(stateCities[c]);
+					cities.push_back(stateCities[c]);
+				}
+			}
+
+			if (!ok)
+			{
+				for (size_t v = 0; v < newVertices.size(); v++)
+				{
+					delete newVertices[v];
+				}
+				return false;
+			}
+
+			vertexList.swap(newVertices);
+			mapAdjList.swap(newAdjList);
+			cityByState.swap(newByState);
+			id = header.nextID;
+			num_edges = (int)header.numEdges;
+
+			cityLookup.clear();
+			box = llBox();
+			vertexData.clear();
+			regions.clear();
+			for (size_t v = 0; v < vertexList.size(); v++)
+			{
+				cityLookup[vertexList[v]->city] = vertexList[v]->ID;
+				box.addLatLon(vertexList[v]->loc);
+				vertexData.add(vertexList[v]->city, vertexList[v]->state, vertexList[v]->loc.lat, vertexList[v]->loc.lon);
+			}
+			return true;
+		}
+
 		void lookupHelp()
 		{
 			for (int v1 = 0; v1 < vertexList.size(); v1++)
@@ -0,0 +1,325 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "geo.h"
+#include "vertex_store.h"
+
+using namespace std;
+
+/**
+ * gridIndex - buckets the vertices into lat/lon grid cells, for radius and
+ * bounding box queries.
+ *
+ * The grid covers the vertices' own lat/lon extent, and its cell size is
+ * picked from the data when it is built: about PER_CELL vertices per cell
+ * on average, with cells about as wide as they are tall in miles at the
+ * middle latitude. Building is a counting sort, two passes over the
+ * vertices. The vertices are then stored cell by cell, with their own copy
+ * of lat/lon and unit vector, so a query only reads the cells its circle
+ * or box touches, front to back.
+ *
+ * Radius queries use the same test as kdTree::withinRadius (CHORD2 against
+ * milesToChord2), so the two return the same vertices. Like kdTree it is a
+ * snapshot of the store it was built from; isCurrent() says whether the
+ * store has changed since (vertexStore::generation).
+ *
+ *     gridIndex grid(G.vertexData);
+ *     vector<int> close = grid.withinRadius(latlon(33.9, -98.5), 25);
+ *     vector<int> shown = grid.inBox(llBox(latlon(37, -103), latlon(33.6, -94.4)));
+ */
+class gridIndex
+{
+  public:
+    gridIndex() { clear(); }
+    gridIndex(const vertexStore &S) { build(S); }
+
+    /**
+     * build - indexes every vertex in S
+     * Params:
+     *     const vertexStore& S: the vertices
+     * Returns
+     *     void
+     */
+    void build(const vertexStore &S)
+    {
+        int n = S.size();
+
+        clear();
+        builtFrom = S.generation;
+        if (n == 0)
+        {
+            return;
+        }
+
+        latLo = latHi = S.lat[0];
+        lonLo = lonHi = S.lon[0];
+        for (int i = 1; i < n; i++)
+        {
+            latLo = min(latLo, S.lat[i]);
+            latHi = max(latHi, S.lat[i]);
+            lonLo = min(lonLo, S.lon[i]);
+            lonHi = max(lonHi, S.lon[i]);
+        }
+
+        // cells about square on the ground, about PER_CELL vertices each
+        double height = max(latHi - latLo, 1e-9);
+        double width = max((lonHi - lonLo) * cos(deg2rad((latLo + latHi) / 2)), 1e-9);
+        double cells = max(1.0, (double)n / PER_CELL);
+
+        rows = (int)min(cells, max(1.0, round(sqrt(cells * height / width))));
+        cols = (int)min(cells, max(1.0, round(cells / rows)));
+        rowScale = rows / max(latHi - latLo, 1e-9);
+        colScale = cols / max(lonHi - lonLo, 1e-9);
+
+        // counting sort by cell
+        vector<int> cellOf(n);
+        cellStart.assign((size_t)rows * cols + 1, 0);
+        for (int i = 0; i < n; i++)
+        {
+            cellOf[i] = row(S.lat[i]) * cols + col(S.lon[i]);
+            cellStart[cellOf[i] + 1]++;
+        }
+        for (size_t c = 1; c < cellStart.size(); c++)
+        {
+            cellStart[c] += cellStart[c - 1];
+        }
+
+        vector<int> fill(cellStart.begin(), cellStart.end() - 1);
+        ids.resize(n);
+        plat.resize(n);
+        plon.resize(n);
+        px.resize(n);
+        py.resize(n);
+        pz.resize(n);
+        where.resize(n);
+        for (int i = 0; i < n; i++)
+        {
+            int at = fill[cellOf[i]]++;
+            ids[at] = i;
+            where[i] = at;
+            plat[at] = S.lat[i];
+            plon[at] = S.lon[i];
+            px[at] = S.x[i];
+            py[at] = S.y[i];
+            pz[at] = S.z[i];
+        }
+    }
+
+    void clear()
+    {
+        rows = cols = 0;
+        latLo = latHi = lonLo = lonHi = 0;
+        rowScale = colScale = 0;
+        cellStart.assign(1, 0);
+        ids.clear();
+        plat.clear();
+        plon.clear();
+        px.clear();
+        py.clear();
+        pz.clear();
+        where.clear();
+        builtFrom = 0;
+    }
+
+    int size() const { return (int)ids.size(); }
+
+    /**
+     * isCurrent - true if the grid was built from S as it is now
+     */
+    bool isCurrent(const vertexStore &S) const { return builtFrom == S.generation; }
+
+    /**
+     * withinRadius - the vertices at most `miles` from vertex id (not
+     *     counting id)
+     * Returns
+     *     vector<int>: IDs, nearest first
+     */
+    vector<int> withinRadius(int id, double miles) const
+    {
+        if (id < 0 || id >= size())
+        {
+            return vector<int>();
+        }
+        int at = where[id];
+        vector<int> found = radius(plat[at], plon[at], px[at], py[at], pz[at], miles);
+        found.erase(remove(found.begin(), found.end(), id), found.end());
+        return found;
+    }
+
+    /**
+     * withinRadius - the vertices at most `miles` from a location
+     * Returns
+     *     vector<int>: IDs, nearest first
+     */
+    vector<int> withinRadius(latlon ll, double miles) const
+    {
+        double x, y, z;
+        unitVector(ll.lat, ll.lon, x, y, z);
+        return radius(ll.lat, ll.lon, x, y, z, miles);
+    }
+
+    /**
+     * inBox - the vertices inside a bounding box, edges included. Either
+     *     pair of opposite corners will do; the box does not wrap at +-180
+     *     longitude.
+     * Params:
+     *     const llBox& box: the box (an empty llBox matches nothing)
+     * Returns
+     *     vector<int>: IDs, in no particular order
+     */
+    vector<int> inBox(const llBox &box) const
+    {
+        vector<int> found;
+
+        if (!box.init || size() == 0)
+        {
+            return found;
+        }
+
+        double south = min(box.tl_ll.lat, box.br_ll.lat);
+        double north = max(box.tl_ll.lat, box.br_ll.lat);
+        double west = min(box.tl_ll.lon, box.br_ll.lon);
+        double east = max(box.tl_ll.lon, box.br_ll.lon);
+
+        if (north < latLo || south > latHi || east < lonLo || west > lonHi)
+        {
+            return found;
+        }
+
+        int r0 = row(south), r1 = row(north);
+        int c0 = col(west), c1 = col(east);
+        for (int r = r0; r <= r1; r++)
+        {
+            for (int c = c0; c <= c1; c++)
+            {
+                int first = cellStart[r * cols + c];
+                int last = cellStart[r * cols + c + 1];
+
+                // cells away from the box's edge are inside it: no tests
+                if (r > r0 && r < r1 && c > c0 && c < c1)
+                {
+                    found.insert(found.end(), ids.begin() + first, ids.begin() + last);
+                    continue;
+                }
+                for (int i = first; i < last; i++)
+                {
+                    if (plat[i] >= south && plat[i] <= north && plon[i] >= west && plon[i] <= east)
+                    {
+                        found.push_back(ids[i]);
+                    }
+                }
+            }
+        }
+        return found;
+    }
+
+  private:
+    static const int PER_CELL = 4; // average vertices per cell
+
+    int rows, cols;
+    double latLo, latHi, lonLo, lonHi; // extent of the vertices
+    double rowScale, colScale;         // cells per degree
+
+    vector<int> cellStart;    // cell c's vertices are [cellStart[c], cellStart[c+1])
+    vector<int> ids;          // vertex ID at each position
+    vector<double> plat;      // coordinates, cell by cell
+    vector<double> plon;
+    vector<double> px;
+    vector<double> py;
+    vector<double> pz;
+    vector<int> where;        // position of each vertex ID
+    uint64_t builtFrom;       // vertexStore::generation it was built from
+
+    // cell row / column of a lat / lon, clamped to the grid
+    int row(double lat) const
+    {
+        double r = floor((lat - latLo) * rowScale);
+        return r < 0 ? 0 : (r >= rows ? rows - 1 : (int)r);
+    }
+
+    int col(double lon) const
+    {
+        double c = floor((lon - lonLo) * colScale);
+        return c < 0 ? 0 : (c >= cols ? cols - 1 : (int)c);
+    }
+
+    typedef pair<double, int> hit; // CHORD2 distance, ID
+
+    // tests the vertices in rows r0..r1, columns c0..c1
+    void scan(int r0, int r1, int c0, int c1, double x, double y, double z, double limit, vector<hit> &hits) const
+    {
+        for (int r = r0; r <= r1 && c0 <= c1; r++)
+        {
+            for (int i = cellStart[r * cols + c0]; i < cellStart[r * cols + c1 + 1]; i++)
+            {
+                double dx = px[i] - x, dy = py[i] - y, dz = pz[i] - z;
+                double d = dx * dx + dy * dy + dz * dz;
+                if (d <= limit)
+                {
+                    hits.push_back(hit(d, ids[i]));
+                }
+            }
+        }
+    }
+
+    vector<int> radius(double lat, double lon, double x, double y, double z, double miles) const
+    {
+        vector<hit> hits;
+        vector<int> found;
+        double limit = milesToChord2(miles);
+
+        if (size() == 0 || miles < 0)
+        {
+            return found;
+        }
+
+        // the circle's extent in degrees (deg2rad's degrees, as unitVector
+        // uses): its angle north and south, and east and west the widest
+        // it gets, unless it reaches over a pole
+        double angle = miles / earthRadiusMi;
+        double latr = deg2rad(lat);
+        double south = lat - rad2deg(angle);
+        double north = lat + rad2deg(angle);
+        double west = -1e9, east = 1e9;
+
+        if (fabs(latr) + angle < 1.5707963267948966)
+        {
+            double spread = rad2deg(asin(min(1.0, sin(angle) / cos(latr)))) + 1e-9;
+            west = lon - spread;
+            east = lon + spread;
+        }
+        if (north < latLo || south > latHi)
+        {
+            return found;
+        }
+
+        int r0 = row(south), r1 = row(north);
+        int c0 = col(west), c1 = col(east);
+        if (east < lonLo || west > lonHi)
+        {
+            c0 = cols;
+            c1 = -1;
+        }
+        scan(r0, r1, c0, c1, x, y, z, limit, hits);
+        // a circle over +-180 longitude comes back in on the other side,
+        // in columns the first scan didn't cover
+        if (west < -180 && west + 360 <= lonHi)
+        {
+            scan(r0, r1, max(col(west + 360), c1 + 1), cols - 1, x, y, z, limit, hits);
+        }
+        if (east > 180 && east - 360 >= lonLo)
+        {
+            scan(r0, r1, 0, min(col(east - 360), c0 - 1), x, y, z, limit, hits);
+        }
+
+        sort(hits.begin(), hits.end());
+        found.resize(hits.size());
+        for (size_t i = 0; i < hits.size(); i++)
+        {
+            found[i] = hits[i].second;
+        }
+        return found;
+    }
+};
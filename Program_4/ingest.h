@@ -0,0 +1,296 @@
+#pragma once
+
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include "csv.h"
+#include "graph.h"
+
+// Columns of cities.csv / filtered_cities.csv, with the defaults for
+// empty fields.
+inline const auto citySchema = csvSchema<cityRecord>(
+    csvColumn(0, &cityRecord::zip),
+    csvColumn(1, &cityRecord::lat, 0.0),
+    csvColumn(2, &cityRecord::lon, 0.0),
+    csvColumn(3, &cityRecord::city),
+    csvColumn(4, &cityRecord::state),
+    csvColumn(5, &cityRecord::county));
+
+/**
+ * ingestStats - what a cityIngest run did with the rows it read.
+ */
+struct ingestStats
+{
+    std::size_t rows;       // rows read
+    std::size_t kept;       // rows written out
+    std::size_t duplicates; // rows dropped because their key was seen
+    std::size_t rejected;   // rows written to the rejects report
+};
+
+/**
+ * cityIngest - the cleaning step run on every refresh of the city data.
+ *
+ * Streams a city file (zip,lat,lon,city,state,county) once, front to
+ * back, and writes the first row for each dedup key:
+ *
+ *     byCity       city name only (what the old filterDups did, so
+ *                  Springfield, IL and Springfield, MO are one city)
+ *     byCityState  city name and state
+ *     byZip        zip code
+ *
+ * Rows with too few fields or with a missing (empty, unparsable or zero)
+ * lat/lon are not deduped; they go to the rejects report instead, as
+ * "line,reason,row" (the row as it was in the file, quoted if needed).
+ * The seen keys are views into the mapped input, so memory grows with the
+ * number of distinct keys only, and the output is written through a
+ * buffer with to_chars, in the shortest form that reads back to the same
+ * double.
+ *
+ *     cityIngest ingest(cityIngest::byCityState);
+ *     ingest.run("cities.csv", "filtered_cities.csv", "rejects.csv");
+ */
+class cityIngest
+{
+    public:
+        enum dedupKey { byCity, byCityState, byZip };
+
+        cityIngest(dedupKey key = byCityState) : m_key(key) { clearStats(); }
+
+        /**
+         * run - cleans one file
+         * Params:
+         *     string infile   - city file to read
+         *     string outfile  - cleaned rows
+         *     string rejects  - rejects report ("" for none)
+         * Returns
+         *     bool: false if a file could not be opened
+         */
+        bool run(std::string infile, std::string outfile, std::string rejects = "")
+        {
+            clearStats();
+
+            CSVReader file(infile);
+            std::ofstream out(outfile, std::ios::binary);
+            std::ofstream bad;
+
+            if (!file.good() || !out)
+            {
+                return false;
+            }
+            if (!rejects.empty())
+            {
+                bad.open(rejects, std::ios::binary);
+                if (!bad)
+                {
+                    return false;
+                }
+            }
+
+            std::unordered_set<key, keyHash> seen;
+            std::deque<std::string> copies;
+            std::string outBuffer, badBuffer, fieldBuffer;
+            CSVRowView row;
+            cityRecord rec;
+            const char *p = file.data();
+            const char *end = p + file.size();
+            std::size_t line = 1;     // line the row starts on
+            std::size_t nextLine = 1;
+
+            while (p < end)
+            {
+                const char *start = p;
+                p = CSVReader::parseRow(p, end, row, fieldBuffer);
+                line = nextLine;
+                nextLine += std::count(start, p, '\n');
+
+                if (row.size() == 1 && row[0].empty())
+                {
+                    continue; // blank line
+                }
+                m_stats.rows++;
+
+                const char *reason = NULL;
+                if (!citySchema.parse(row, rec))
+                {
+                    reason = "too few fields";
+                }
+                else if (rec.lat == 0 || rec.lon == 0)
+                {
+                    reason = "missing lat/lon";
+                }
+
+                if (reason)
+                {
+                    m_stats.rejected++;
+                    if (bad.is_open())
+                    {
+                        appendInt(badBuffer, (long long)line);
+                        badBuffer += ',';
+                        badBuffer += reason;
+                        badBuffer += ',';
+                        appendField(badBuffer, std::string_view(start, rowLength(start, p)));
+                        badBuffer += '\n';
+                        flush(bad, badBuffer);
+                    }
+                    continue;
+                }
+
+                if (!seen.insert(makeKey(rec, start, p, copies)).second)
+                {
+                    m_stats.duplicates++;
+                    continue;
+                }
+
+                m_stats.kept++;
+                appendInt(outBuffer, rec.zip);
+                outBuffer += ',';
+                appendDouble(outBuffer, rec.lat);
+                outBuffer += ',';
+                appendDouble(outBuffer, rec.lon);
+                outBuffer += ',';
+                appendField(outBuffer, rec.city);
+                outBuffer += ',';
+                appendField(outBuffer, rec.state);
+                outBuffer += ',';
+                appendField(outBuffer, rec.county);
+                outBuffer += '\n';
+                flush(out, outBuffer);
+            }
+
+            flush(out, outBuffer, true);
+            if (bad.is_open())
+            {
+                flush(bad, badBuffer, true);
+            }
+            return out.good();
+        }
+
+        const ingestStats& stats() const { return m_stats; }
+
+    private:
+        /**
+         * key - one dedup key. Only the parts the mode uses are filled in.
+         */
+        struct key
+        {
+            std::string_view city;
+            std::string_view state;
+            int zip;
+
+            bool operator==(const key& rhs) const
+            {
+                return zip == rhs.zip && city == rhs.city && state == rhs.state;
+            }
+        };
+
+        struct keyHash
+        {
+            std::size_t operator()(const key& k) const
+            {
+                std::hash<std::string_view> h;
+                std::size_t seed = h(k.city);
+                seed ^= h(k.state) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+                seed ^= std::hash<int>()(k.zip) + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2);
+                return seed;
+            }
+        };
+
+        /**
+         * makeKey - builds the row's key. Fields that had "" escapes live
+         * in the reader's buffer, which the next row reuses, so those are
+         * copied out to stay valid in the seen-set.
+         */
+        key makeKey(const cityRecord& rec, const char *begin, const char *end, std::deque<std::string>& copies) const
+        {
+            key k = { std::string_view(), std::string_view(), 0 };
+
+            if (m_key == byZip)
+            {
+                k.zip = rec.zip;
+                return k;
+            }
+            k.city = stable(rec.city, begin, end, copies);
+            if (m_key == byCityState)
+            {
+                k.state = stable(rec.state, begin, end, copies);
+            }
+            return k;
+        }
+
+        static std::string_view stable(std::string_view field, const char *begin, const char *end, std::deque<std::string>& copies)
+        {
+            if (field.empty() || (field.data() >= begin && field.data() < end))
+            {
+                return field;
+            }
+            copies.push_back(std::string(field));
+            return copies.back();
+        }
+
+        // length of a row without its line end
+        static std::size_t rowLength(const char *begin, const char *end)
+        {
+            while (end > begin && (end[-1] == '\n' || end[-1] == '\r'))
+            {
+                end--;
+            }
+            return end - begin;
+        }
+
+        // a text field, quoted if it holds anything csv would split on
+        static void appendField(std::string& buffer, std::string_view field)
+        {
+            if (field.find_first_of(",\"\r\n") == std::string_view::npos)
+            {
+                buffer.append(field);
+                return;
+            }
+            buffer += '"';
+            for (std::size_t i = 0; i < field.size(); i++)
+            {
+                if (field[i] == '"')
+                {
+                    buffer += '"';
+                }
+                buffer += field[i];
+            }
+            buffer += '"';
+        }
+
+        static void appendInt(std::string& buffer, long long value)
+        {
+            char text[24];
+            char *stop = std::to_chars(text, text + sizeof(text), value).ptr;
+            buffer.append(text, stop - text);
+        }
+
+        static void appendDouble(std::string& buffer, double value)
+        {
+            char text[32];
+            char *stop = std::to_chars(text, text + sizeof(text), value).ptr;
+            buffer.append(text, stop - text);
+        }
+
+        // writes the buffer out once it is big enough (or always, at the end)
+        static void flush(std::ofstream& out, std::string& buffer, bool force = false)
+        {
+            if (force || buffer.size() >= (1 << 16))
+            {
+                out.write(buffer.data(), buffer.size());
+                buffer.clear();
+            }
+        }
+
+        void clearStats()
+        {
+            m_stats.rows = m_stats.kept = m_stats.duplicates = m_stats.rejected = 0;
+        }
+
+        dedupKey    m_key;
+        ingestStats m_stats;
+};
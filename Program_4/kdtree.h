@@ -0,0 +1,458 @@
+#pragma once
+
+#include <vector>
+#include <queue>
+#include <algorithm>
+#include <limits>
+#include "geo.h"
+#include "vertex_store.h"
+
+using namespace std;
+
+/**
+ * kdTree - a k-d tree over the vertices' unit vectors, for nearest
+ * neighbor and radius queries.
+ *
+ * Working on the unit vectors (see vertexStore) rather than lat/lon means
+ * straight-line (CHORD2) distance orders points exactly like great circle
+ * distance, with no seams at the poles or at +-180 longitude. The tree is
+ * implicit: the points are reordered so every node is a range whose middle
+ * point splits it on the axis where the range is widest, and the tree keeps
+ * its own copy of the coordinates in that order.
+ *
+ * It is a snapshot of the store it was built from; isCurrent() says
+ * whether the store has changed since (vertexStore::generation). Ties in
+ * distance go to the lower ID.
+ *
+ * remove() takes a vertex out of the answers without rebuilding. Every
+ * node keeps a count of the vertices still in its range, and searches
+ * skip ranges whose count is 0, so a builder that removes the vertices
+ * its filter will never accept again (visited, full) keeps its queries
+ * short instead of wading through more and more rejected vertices.
+ *
+ *     kdTree T(G.vertexData);
+ *     vector<int> near = T.kNearest(G.cityLookup["Lebanon"], 3);
+ */
+class kdTree
+{
+  public:
+    kdTree() { builtFrom = 0; }
+    kdTree(const vertexStore &S) { build(S); }
+
+    /**
+     * build - indexes every vertex in S
+     * Params:
+     *     const vertexStore& S: the vertices
+     * Returns
+     *     void
+     */
+    void build(const vertexStore &S)
+    {
+        int n = S.size();
+
+        ids.resize(n);
+        for (int i = 0; i < n; i++)
+        {
+            ids[i] = i;
+        }
+        axis.assign(n, 0);
+        split(S, 0, n);
+
+        px.resize(n);
+        py.resize(n);
+        pz.resize(n);
+        where.resize(n);
+        for (int i = 0; i < n; i++)
+        {
+            where[ids[i]] = i;
+            px[i] = S.x[ids[i]];
+            py[i] = S.y[ids[i]];
+            pz[i] = S.z[ids[i]];
+        }
+
+        dead.assign(n, 0);
+        live.assign(n, 0);
+        count(0, n);
+        builtFrom = S.generation;
+    }
+
+    void clear()
+    {
+        ids.clear();
+        axis.clear();
+        px.clear();
+        py.clear();
+        pz.clear();
+        where.clear();
+        dead.clear();
+        live.clear();
+        builtFrom = 0;
+    }
+
+    int size() const { return (int)ids.size(); }
+
+    /**
+     * isCurrent - true if the tree was built from S as it is now
+     */
+    bool isCurrent(const vertexStore &S) const { return builtFrom == S.generation; }
+
+    /**
+     * remove - leaves vertex id out of every later answer (it can still be
+     *     searched around). Only a new build() brings it back.
+     */
+    void remove(int id)
+    {
+        int at = position(id);
+        if (at < 0 || dead[at])
+        {
+            return;
+        }
+        dead[at] = 1;
+
+        int lo = 0, hi = size();
+        while (hi - lo > LEAF)
+        {
+            int mid = (lo + hi) / 2;
+            live[mid]--;
+            if (at == mid)
+            {
+                return;
+            }
+            if (at < mid)
+            {
+                hi = mid;
+            }
+            else
+            {
+                lo = mid + 1;
+            }
+        }
+        live[lo]--;
+    }
+
+    /**
+     * kNearest - the k vertices closest to vertex id (not counting id)
+     * Returns
+     *     vector<int>: IDs, nearest first (fewer than k if there aren't k)
+     */
+    vector<int> kNearest(int id, int k) const
+    {
+        return kNearestIf(id, k, [](int) { return true; });
+    }
+
+    /**
+     * kNearest - the k vertices closest to a location
+     */
+    vector<int> kNearest(latlon ll, int k) const
+    {
+        double x, y, z;
+        unitVector(ll.lat, ll.lon, x, y, z);
+        return search(x, y, z, k, [](int) { return true; });
+    }
+
+    /**
+     * kNearestIf - the k vertices closest to vertex id that accept(ID)
+     *     says yes to. Rejected vertices are skipped, not counted, so the
+     *     search goes on until k are found (or the tree runs out).
+     * Params:
+     *     int id: vertex to search around (never returned)
+     *     int k: how many to find
+     *     Accept accept: bool(int ID)
+     */
+    template <class Accept>
+    vector<int> kNearestIf(int id, int k, Accept accept) const
+    {
+        int at = position(id);
+        if (at < 0)
+        {
+            return vector<int>();
+        }
+        return search(px[at], py[at], pz[at], k, [&](int v) { return v != id && accept(v); });
+    }
+
+    /**
+     * withinRadius - the vertices at most `miles` from vertex id (not
+     *     counting id)
+     * Returns
+     *     vector<int>: IDs, nearest first
+     */
+    vector<int> withinRadius(int id, double miles) const
+    {
+        int at = position(id);
+        if (at < 0)
+        {
+            return vector<int>();
+        }
+        vector<int> found = radius(px[at], py[at], pz[at], miles);
+        found.erase(std::remove(found.begin(), found.end(), id), found.end());
+        return found;
+    }
+
+    /**
+     * withinRadius - the vertices at most `miles` from a location
+     */
+    vector<int> withinRadius(latlon ll, double miles) const
+    {
+        double x, y, z;
+        unitVector(ll.lat, ll.lon, x, y, z);
+        return radius(x, y, z, miles);
+    }
+
+  private:
+    static const int LEAF = 8; // ranges this small are scanned, not split
+
+    typedef pair<double, int> hit; // CHORD2 distance, ID
+
+    vector<int> ids;           // vertex ID at each tree position
+    vector<unsigned char> axis; // split axis of the node whose middle is here
+    vector<double> px;         // coordinates in tree order
+    vector<double> py;
+    vector<double> pz;
+    vector<int> where;         // tree position of each vertex ID
+    vector<char> dead;         // removed, by tree position
+    vector<int> live;          // vertices not removed in a node's range,
+                               // kept at its middle (a leaf: its first)
+    uint64_t builtFrom;        // vertexStore::generation it was built from
+
+    double coord(int at, int a) const
+    {
+        return a == 0 ? px[at] : (a == 1 ? py[at] : pz[at]);
+    }
+
+    static double storeCoord(const vertexStore &S, int id, int a)
+    {
+        return a == 0 ? S.x[id] : (a == 1 ? S.y[id] : S.z[id]);
+    }
+
+    void split(const vertexStore &S, int lo, int hi)
+    {
+        if (hi - lo <= LEAF)
+        {
+            return;
+        }
+
+        double low[3] = { 2, 2, 2 };
+        double high[3] = { -2, -2, -2 };
+        for (int i = lo; i < hi; i++)
+        {
+            for (int a = 0; a < 3; a++)
+            {
+                double c = storeCoord(S, ids[i], a);
+                low[a] = min(low[a], c);
+                high[a] = max(high[a], c);
+            }
+        }
+        int a = 0;
+        for (int b = 1; b < 3; b++)
+        {
+            if (high[b] - low[b] > high[a] - low[a])
+            {
+                a = b;
+            }
+        }
+
+        int mid = (lo + hi) / 2;
+        nth_element(ids.begin() + lo, ids.begin() + mid, ids.begin() + hi, [&](int u, int v) {
+            return storeCoord(S, u, a) < storeCoord(S, v, a);
+        });
+        axis[mid] = (unsigned char)a;
+        split(S, lo, mid);
+        split(S, mid + 1, hi);
+    }
+
+    // fills live[] for the range [lo, hi)
+    void count(int lo, int hi)
+    {
+        if (hi <= lo)
+        {
+            return;
+        }
+        if (hi - lo <= LEAF)
+        {
+            live[lo] = hi - lo;
+            return;
+        }
+        int mid = (lo + hi) / 2;
+        live[mid] = hi - lo;
+        count(lo, mid);
+        count(mid + 1, hi);
+    }
+
+    // vertices not removed in the range [lo, hi)
+    int liveIn(int lo, int hi) const
+    {
+        if (hi <= lo)
+        {
+            return 0;
+        }
+        return live[hi - lo <= LEAF ? lo : (lo + hi) / 2];
+    }
+
+    // tree position of vertex id, -1 if it isn't in the tree
+    int position(int id) const
+    {
+        return id >= 0 && id < size() ? where[id] : -1;
+    }
+
+    double chord2(int at, double x, double y, double z) const
+    {
+        double dx = px[at] - x, dy = py[at] - y, dz = pz[at] - z;
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    template <class Accept>
+    vector<int> search(double x, double y, double z, int k, Accept accept) const
+    {
+        priority_queue<hit> best; // worst of the k best on top
+        vector<int> found;
+
+        if (k <= 0 || size() == 0)
+        {
+            return found;
+        }
+        nearest(0, size(), x, y, z, k, accept, best);
+
+        found.resize(best.size());
+        for (int i = (int)best.size() - 1; i >= 0; i--)
+        {
+            found[i] = best.top().second;
+            best.pop();
+        }
+        return found;
+    }
+
+    template <class Accept>
+    void consider(int at, double x, double y, double z, int k, Accept &accept, priority_queue<hit> &best) const
+    {
+        if (dead[at])
+        {
+            return;
+        }
+        hit h(chord2(at, x, y, z), ids[at]);
+        if ((int)best.size() == k && !(h < best.top()))
+        {
+            return;
+        }
+        if (!accept(ids[at]))
+        {
+            return;
+        }
+        best.push(h);
+        if ((int)best.size() > k)
+        {
+            best.pop();
+        }
+    }
+
+    template <class Accept>
+    void nearest(int lo, int hi, double x, double y, double z, int k, Accept &accept, priority_queue<hit> &best) const
+    {
+        if (liveIn(lo, hi) == 0)
+        {
+            return;
+        }
+        if (hi - lo <= LEAF)
+        {
+            for (int i = lo; i < hi; i++)
+            {
+                consider(i, x, y, z, k, accept, best);
+            }
+            return;
+        }
+
+        int mid = (lo + hi) / 2;
+        double q[3] = { x, y, z };
+        double diff = q[axis[mid]] - coord(mid, axis[mid]);
+
+        consider(mid, x, y, z, k, accept, best);
+        if (diff < 0)
+        {
+            nearest(lo, mid, x, y, z, k, accept, best);
+        }
+        else
+        {
+            nearest(mid + 1, hi, x, y, z, k, accept, best);
+        }
+        // the far side can only help if the splitting plane is close enough
+        if ((int)best.size() < k || diff * diff <= best.top().first)
+        {
+            if (diff < 0)
+            {
+                nearest(mid + 1, hi, x, y, z, k, accept, best);
+            }
+            else
+            {
+                nearest(lo, mid, x, y, z, k, accept, best);
+            }
+        }
+    }
+
+    vector<int> radius(double x, double y, double z, double miles) const
+    {
+        vector<hit> hits;
+        vector<int> found;
+        double limit = milesToChord2(miles);
+        int stack[128][2];
+        int top = 0;
+
+        if (size() > 0)
+        {
+            stack[top][0] = 0;
+            stack[top][1] = size();
+            top++;
+        }
+
+        double q[3] = { x, y, z };
+        while (top > 0)
+        {
+            top--;
+            int lo = stack[top][0];
+            int hi = stack[top][1];
+
+            if (liveIn(lo, hi) == 0)
+            {
+                continue;
+            }
+            if (hi - lo <= LEAF)
+            {
+                for (int i = lo; i < hi; i++)
+                {
+                    double d = chord2(i, x, y, z);
+                    if (!dead[i] && d <= limit)
+                    {
+                        hits.push_back(hit(d, ids[i]));
+                    }
+                }
+                continue;
+            }
+
+            int mid = (lo + hi) / 2;
+            double d = chord2(mid, x, y, z);
+            double diff = q[axis[mid]] - coord(mid, axis[mid]);
+
+            if (!dead[mid] && d <= limit)
+            {
+                hits.push_back(hit(d, ids[mid]));
+            }
+            if (diff < 0 || diff * diff <= limit)
+            {
+                stack[top][0] = lo;
+                stack[top][1] = mid;
+                top++;
+            }
+            if (diff >= 0 || diff * diff <= limit)
+            {
+                stack[top][0] = mid + 1;
+                stack[top][1] = hi;
+                top++;
+            }
+        }
+
+        sort(hits.begin(), hits.end());
+        for (size_t i = 0; i < hits.size(); i++)
+        {
+            found.push_back(hits[i].second);
+        }
+        return found;
+    }
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <string>
+#include <cstddef>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * MappedFile - maps a whole file read-only into memory so it can be
+ * parsed in place instead of being copied through an istream.
+ *
+ * Anything pointing into data() is only valid while the MappedFile is
+ * open, so keep it alive for as long as those pointers are used.
+ */
+class MappedFile
+{
+    public:
+        MappedFile() { init(); }
+        MappedFile(std::string filename) { init(); open(filename); }
+        ~MappedFile() { close(); }
+
+        /**
+         * open - maps the named file. An empty file opens fine but has a
+         * NULL data() and a size() of 0.
+         * Params:
+         *     string filename  - file to map
+         * Returns
+         *     bool: true if the file could be mapped
+         */
+        bool open(std::string filename)
+        {
+            close();
+#ifdef _WIN32
+            m_file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+                OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+            if (m_file == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+            LARGE_INTEGER fileSize;
+            GetFileSizeEx(m_file, &fileSize);
+            m_size = (std::size_t)fileSize.QuadPart;
+
+            if (m_size > 0)
+            {
+                m_map = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+                if (m_map)
+                {
+                    m_data = (const char *)MapViewOfFile(m_map, FILE_MAP_READ, 0, 0, 0);
+                }
+                if (!m_data)
+                {
+                    close();
+                    return false;
+                }
+            }
+#else
+            m_fd = ::open(filename.c_str(), O_RDONLY);
+            if (m_fd < 0)
+            {
+                return false;
+            }
+            struct stat info;
+            if (fstat(m_fd, &info) != 0)
+            {
+                close();
+                return false;
+            }
+            m_size = (std::size_t)info.st_size;
+
+            if (m_size > 0)
+            {
+                void *p = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_fd, 0);
+                if (p == MAP_FAILED)
+                {
+                    close();
+                    return false;
+                }
+                m_data = (const char *)p;
+                madvise(p, m_size, MADV_SEQUENTIAL);
+            }
+#endif
+            m_open = true;
+            return true;
+        }
+
+        /**
+         * close - unmaps the file. Safe to call more than once.
+         */
+        void close()
+        {
+#ifdef _WIN32
+            if (m_data)
+            {
+                UnmapViewOfFile(m_data);
+            }
+            if (m_map)
+            {
+                CloseHandle(m_map);
+            }
+            if (m_file != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(m_file);
+            }
+            m_map = NULL;
+            m_file = INVALID_HANDLE_VALUE;
+#else
+            if (m_data)
+            {
+                munmap((void *)m_data, m_size);
+            }
+            if (m_fd >= 0)
+            {
+                ::close(m_fd);
+            }
+            m_fd = -1;
+#endif
+            m_data = NULL;
+            m_size = 0;
+            m_open = false;
+        }
+
+        bool good() const { return m_open; }
+        const char *data() const { return m_data; }
+        std::size_t size() const { return m_size; }
+
+    private:
+        MappedFile(const MappedFile &);
+        MappedFile &operator=(const MappedFile &);
+
+        void init()
+        {
+            m_data = NULL;
+            m_size = 0;
+            m_open = false;
+#ifdef _WIN32
+            m_file = INVALID_HANDLE_VALUE;
+            m_map = NULL;
+#else
+            m_fd = -1;
+#endif
+        }
+
+        const char *m_data;
+        std::size_t m_size;
+        bool m_open;
+#ifdef _WIN32
+        HANDLE m_file;
+        HANDLE m_map;
+#else
+        int m_fd;
+#endif
+};
@@ -0,0 +1,422 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <cmath>
+#include "geo.h"
+#include "vertex_store.h"
+
+using namespace std;
+
+/**
+ * rTree - an R-tree over the vertices (as points) and the edges (as the
+ * lat/lon rectangle around their two ends), for viewport queries.
+ *
+ * build() bulk-loads it with Sort-Tile-Recursive packing: the entries are
+ * sorted into vertical slices by longitude, each slice is sorted by
+ * latitude and cut into full nodes, and the same is done to the nodes a
+ * level up until one root is left. That gives full nodes that hardly
+ * overlap. After that, insertVertex / insertEdge add one entry at a time
+ * (least enlargement, splitting nodes that overflow), so the graph can
+ * keep the tree current as it grows instead of rebuilding it.
+ *
+ * Edges are stored as segments, one per pair of connected vertices however
+ * many edges (in either direction) join them, since that is what gets
+ * drawn. Boxes are llBoxes (either pair of opposite corners) and don't
+ * wrap at +-180 longitude.
+ *
+ *     rTree T;
+ *     T.build(G.vertexData, segments);
+ *     vector<int> shown = T.vertices(llBox(latlon(37, -103), latlon(33.6, -94.4)));
+ */
+class rTree
+{
+  public:
+    rTree() { clear(); }
+
+    /**
+     * build - bulk-loads the tree, replacing what was in it
+     * Params:
+     *     const vertexStore& S: the vertices
+     *     const vector<pair<int,int> >& segments: the edges, as (fromID, toID),
+     *                                             one per connected pair
+     * Returns
+     *     void
+     */
+    void build(const vertexStore &S, const vector<pair<int, int> > &segments)
+    {
+        clear();
+        entries.reserve(S.size() + segments.size());
+        for (int v = 0; v < S.size(); v++)
+        {
+            entries.push_back(pointEntry(v, S.lat[v], S.lon[v]));
+        }
+        for (size_t e = 0; e < segments.size(); e++)
+        {
+            int a = segments[e].first, b = segments[e].second;
+            entries.push_back(segmentEntry(a, b, S.lat[a], S.lon[a], S.lat[b], S.lon[b]));
+        }
+
+        vector<int> level(entries.size());
+        for (size_t i = 0; i < level.size(); i++)
+        {
+            level[i] = (int)i;
+        }
+        bool leaf = true;
+        while (level.size() > 1 || leaf)
+        {
+            level = pack(level, leaf);
+            leaf = false;
+        }
+        root = level[0];
+        built = true;
+    }
+
+    void clear()
+    {
+        entries.clear();
+        nodes.clear();
+        root = -1;
+        vertexEntries = 0;
+        built = false;
+    }
+
+    /**
+     * isBuilt - false until build() is called, and again after clear()
+     */
+    bool isBuilt() const { return built; }
+
+    int vertexCount() const { return vertexEntries; }
+    int edgeCount() const { return (int)entries.size() - vertexEntries; }
+
+    /**
+     * insertVertex - adds one vertex (nothing before the tree is built:
+     *     build() will pick it up)
+     * Params:
+     *     int id: its ID
+     *     double lat, lon: where it is
+     */
+    void insertVertex(int id, double lat, double lon)
+    {
+        if (!built)
+        {
+            return;
+        }
+        entries.push_back(pointEntry(id, lat, lon));
+        insert((int)entries.size() - 1);
+    }
+
+    /**
+     * insertEdge - adds one edge (nothing before the tree is built)
+     * Params:
+     *     int fromID, toID: its ends
+     *     double lat1, lon1, lat2, lon2: where the ends are
+     */
+    void insertEdge(int fromID, int toID, double lat1, double lon1, double lat2, double lon2)
+    {
+        if (!built)
+        {
+            return;
+        }
+        entries.push_back(segmentEntry(fromID, toID, lat1, lon1, lat2, lon2));
+        insert((int)entries.size() - 1);
+    }
+
+    /**
+     * search - everything in a viewport
+     * Params:
+     *     const llBox& box: the viewport (an empty llBox matches nothing)
+     *     vector<int>& inside: filled with the IDs of the vertices inside
+     *                          it, edges of the box included
+     *     vector<pair<int,int> >& crossing: filled with the edges whose
+     *                          rectangle overlaps it, as (fromID, toID)
+     * Returns
+     *     void
+     */
+    void search(const llBox &box, vector<int> &inside, vector<pair<int, int> > &crossing) const
+    {
+        inside.clear();
+        crossing.clear();
+        query(box, &inside, &crossing);
+    }
+
+    /**
+     * vertices - the IDs of the vertices inside a box
+     */
+    vector<int> vertices(const llBox &box) const
+    {
+        vector<int> inside;
+        query(box, &inside, NULL);
+        return inside;
+    }
+
+    /**
+     * edges - the edges whose rectangle overlaps a box, as (fromID, toID)
+     */
+    vector<pair<int, int> > edges(const llBox &box) const
+    {
+        vector<pair<int, int> > crossing;
+        query(box, NULL, &crossing);
+        return crossing;
+    }
+
+  private:
+    static const int MAX_CHILDREN = 16;
+
+    struct rect
+    {
+        double south, north, west, east;
+
+        bool overlaps(const rect &r) const
+        {
+            return south <= r.north && north >= r.south && west <= r.east && east >= r.west;
+        }
+
+        void grow(const rect &r)
+        {
+            south = min(south, r.south);
+            north = max(north, r.north);
+            west = min(west, r.west);
+            east = max(east, r.east);
+        }
+
+        double area() const { return (north - south) * (east - west); }
+        double centerLat() const { return (south + north) / 2; }
+        double centerLon() const { return (west + east) / 2; }
+    };
+
+    struct entry
+    {
+        rect r;
+        int a; // vertex ID, or the edge's fromID
+        int b; // -1 for a vertex, the edge's toID
+    };
+
+    struct node
+    {
+        rect r;
+        bool leaf;         // children are entries, not nodes
+        vector<int> child; // indexes into entries or nodes
+    };
+
+    vector<entry> entries;
+    vector<node> nodes;
+    int root;
+    int vertexEntries;
+    bool built;
+
+    entry pointEntry(int id, double lat, double lon)
+    {
+        vertexEntries++;
+        entry e = { { lat, lat, lon, lon }, id, -1 };
+        return e;
+    }
+
+    static entry segmentEntry(int fromID, int toID, double lat1, double lon1, double lat2, double lon2)
+    {
+        entry e = { { min(lat1, lat2), max(lat1, lat2), min(lon1, lon2), max(lon1, lon2) }, fromID, toID };
+        return e;
+    }
+
+    const rect &bounds(int i, bool leaf) const
+    {
+        return leaf ? entries[i].r : nodes[i].r;
+    }
+
+    int makeNode(bool leaf, vector<int>::const_iterator first, vector<int>::const_iterator last)
+    {
+        node n;
+        n.leaf = leaf;
+        n.child.assign(first, last);
+        n.r = bounds(n.child[0], leaf);
+        for (size_t i = 1; i < n.child.size(); i++)
+        {
+            n.r.grow(bounds(n.child[i], leaf));
+        }
+        nodes.push_back(n);
+        return (int)nodes.size() - 1;
+    }
+
+    // one level of STR packing: groups items into nodes, returns the nodes
+    vector<int> pack(vector<int> items, bool leaf)
+    {
+        vector<int> parents;
+
+        if (items.empty())
+        {
+            node n;
+            n.leaf = true;
+            n.r.south = n.r.west = 1e9;
+            n.r.north = n.r.east = -1e9;
+            nodes.push_back(n);
+            parents.push_back((int)nodes.size() - 1);
+            return parents;
+        }
+
+        size_t pages = (items.size() + MAX_CHILDREN - 1) / MAX_CHILDREN;
+        size_t slices = (size_t)ceil(sqrt((double)pages));
+        size_t perSlice = slices * MAX_CHILDREN;
+
+        sort(items.begin(), items.end(), [&](int u, int v) {
+            return bounds(u, leaf).centerLon() < bounds(v, leaf).centerLon();
+        });
+        for (size_t s = 0; s < items.size(); s += perSlice)
+        {
+            vector<int>::iterator first = items.begin() + s;
+            vector<int>::iterator last = items.begin() + min(items.size(), s + perSlice);
+
+            sort(first, last, [&](int u, int v) {
+                return bounds(u, leaf).centerLat() < bounds(v, leaf).centerLat();
+            });
+            for (vector<int>::iterator p = first; p < last; p += min((ptrdiff_t)MAX_CHILDREN, last - p))
+            {
+                parents.push_back(makeNode(leaf, p, p + min((ptrdiff_t)MAX_CHILDREN, last - p)));
+            }
+        }
+        return parents;
+    }
+
+    void insert(int e)
+    {
+        int sibling = insertInto(root, e);
+        if (sibling >= 0)
+        {
+            // the root split: grow the tree a level
+            vector<int> both;
+            both.push_back(root);
+            both.push_back(sibling);
+            root = makeNode(false, both.begin(), both.end());
+        }
+    }
+
+    // adds entry e below node n; returns the new node if n had to split
+    int insertInto(int n, int e)
+    {
+        const rect &r = entries[e].r;
+
+        if (nodes[n].child.empty())
+        {
+            nodes[n].r = r;
+        }
+        else
+        {
+            nodes[n].r.grow(r);
+        }
+
+        if (nodes[n].leaf)
+        {
+            nodes[n].child.push_back(e);
+        }
+        else
+        {
+            int best = -1;
+            double bestGrowth = 0, bestArea = 0;
+            for (size_t i = 0; i < nodes[n].child.size(); i++)
+            {
+                rect c = nodes[nodes[n].child[i]].r;
+                double area = c.area();
+                c.grow(r);
+                double growth = c.area() - area;
+                if (best < 0 || growth < bestGrowth || (growth == bestGrowth && area < bestArea))
+                {
+                    best = nodes[n].child[i];
+                    bestGrowth = growth;
+                    bestArea = area;
+                }
+            }
+            int sibling = insertInto(best, e);
+            if (sibling >= 0)
+            {
+                nodes[n].child.push_back(sibling);
+            }
+        }
+
+        if ((int)nodes[n].child.size() <= MAX_CHILDREN)
+        {
+            return -1;
+        }
+        return split(n);
+    }
+
+    // halves an overfull node along the axis its children are most spread
+    // out on; returns the new node holding the upper half
+    int split(int n)
+    {
+        bool leaf = nodes[n].leaf;
+        vector<int> items = nodes[n].child;
+        double latLo = 1e9, latHi = -1e9, lonLo = 1e9, lonHi = -1e9;
+
+        for (size_t i = 0; i < items.size(); i++)
+        {
+            const rect &c = bounds(items[i], leaf);
+            latLo = min(latLo, c.centerLat());
+            latHi = max(latHi, c.centerLat());
+            lonLo = min(lonLo, c.centerLon());
+            lonHi = max(lonHi, c.centerLon());
+        }
+        bool byLat = latHi - latLo > lonHi - lonLo;
+        sort(items.begin(), items.end(), [&](int u, int v) {
+            return byLat ? bounds(u, leaf).centerLat() < bounds(v, leaf).centerLat()
+                         : bounds(u, leaf).centerLon() < bounds(v, leaf).centerLon();
+        });
+
+        vector<int>::iterator half = items.begin() + items.size() / 2;
+        int upper = makeNode(leaf, half, items.end());
+        node &lower = nodes[n]; // makeNode may have moved nodes
+        lower.child.assign(items.begin(), half);
+        lower.r = bounds(lower.child[0], leaf);
+        for (size_t i = 1; i < lower.child.size(); i++)
+        {
+            lower.r.grow(bounds(lower.child[i], leaf));
+        }
+        return upper;
+    }
+
+    void query(const llBox &box, vector<int> *inside, vector<pair<int, int> > *crossing) const
+    {
+        if (!box.init || root < 0)
+        {
+            return;
+        }
+
+        rect view = { min(box.tl_ll.lat, box.br_ll.lat), max(box.tl_ll.lat, box.br_ll.lat),
+                      min(box.tl_ll.lon, box.br_ll.lon), max(box.tl_ll.lon, box.br_ll.lon) };
+        vector<int> stack(1, root);
+
+        while (!stack.empty())
+        {
+            const node &n = nodes[stack.back()];
+            stack.pop_back();
+
+            if (n.child.empty() || !n.r.overlaps(view))
+            {
+                continue;
+            }
+            for (size_t i = 0; i < n.child.size(); i++)
+            {
+                if (!n.leaf)
+                {
+                    stack.push_back(n.child[i]);
+                    continue;
+                }
+
+                const entry &e = entries[n.child[i]];
+                if (!e.r.overlaps(view))
+                {
+                    continue;
+                }
+                if (e.b < 0)
+                {
+                    if (inside)
+                    {
+                        inside->push_back(e.a);
+                    }
+                }
+                else if (crossing)
+                {
+                    crossing->push_back(make_pair(e.a, e.b));
+                }
+            }
+        }
+    }
+};
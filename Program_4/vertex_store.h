@@ -0,0 +1,178 @@
+#pragma once
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <atomic>
+#include <cmath>
+#include "geo.h"
+
+using namespace std;
+
+/**
+ * vertexStore - the graph's vertices as parallel arrays, indexed by ID.
+ *
+ * Distance loops only need where a vertex is, so the coordinates are kept
+ * in their own dense arrays: lat/lon in degrees plus the point's unit
+ * vector (x, y, z) on the sphere, worked out once when the vertex is
+ * added. The distance between two vertices is then the chord between
+ * their unit vectors, with no trig per pair beyond one asin:
+ *
+ *     haversine(a, b) = |a - b|^2 / 4, so
+ *     distance = 2 R asin(|a - b| / 2)
+ *
+ * which is distanceEarth's formula (same radians, same radius) rearranged.
+ * distances() does a whole row at once with the SIMD kernel in geo.h.
+ * Both take a distanceMode; searches that only compare distances should
+ * use CHORD2, which orders exactly like EXACT without the asin.
+ * City and state names sit in one string pool.
+ *
+ * generation changes whenever a vertex is added or moved (or the store is
+ * cleared), and no two stores ever share one unless one is a copy of the
+ * other, so an index built over the store can record the generation it
+ * was built from and tell on its own when it is out of date.
+ */
+struct vertexStore
+{
+    vector<double> lat;
+    vector<double> lon;
+    vector<double> x;
+    vector<double> y;
+    vector<double> z;
+    string names;              // city and state names, back to back
+    vector<uint32_t> nameStart; // city i is [2i, 2i+1), state i is [2i+1, 2i+2)
+    uint64_t generation;       // see above
+
+    vertexStore() { clear(); }
+
+    void clear()
+    {
+        lat.clear();
+        lon.clear();
+        x.clear();
+        y.clear();
+        z.clear();
+        names.clear();
+        nameStart.assign(1, 0);
+        generation = nextGeneration();
+    }
+
+    // a generation number no store has had before (never 0)
+    static uint64_t nextGeneration()
+    {
+        static atomic<uint64_t> counter(0);
+        return ++counter;
+    }
+
+    int size() const { return (int)lat.size(); }
+
+    /**
+     * add - appends a vertex; its ID is the old size()
+     * Params:
+     *     string_view city, state: names
+     *     double lat, lon: location in degrees
+     * Returns
+     *     int: the new vertex's ID
+     */
+    int add(string_view city, string_view state, double latitude, double longitude)
+    {
+        lat.push_back(0);
+        lon.push_back(0);
+        x.push_back(0);
+        y.push_back(0);
+        z.push_back(0);
+        move(size() - 1, latitude, longitude);
+
+        names.append(city.data(), city.size());
+        nameStart.push_back((uint32_t)names.size());
+        names.append(state.data(), state.size());
+        nameStart.push_back((uint32_t)names.size());
+        return size() - 1;
+    }
+
+    /**
+     * move - gives vertex id a new location
+     */
+    void move(int id, double latitude, double longitude)
+    {
+        lat[id] = latitude;
+        lon[id] = longitude;
+        unitVector(latitude, longitude, x[id], y[id], z[id]);
+        generation = nextGeneration();
+    }
+
+    string_view city(int id) const
+    {
+        return string_view(names.data() + nameStart[2 * id], nameStart[2 * id + 1] - nameStart[2 * id]);
+    }
+
+    string_view state(int id) const
+    {
+        return string_view(names.data() + nameStart[2 * id + 1], nameStart[2 * id + 2] - nameStart[2 * id + 1]);
+    }
+
+    /**
+     * distance - distance between two vertices (see distanceMode)
+     * Params:
+     *     int a, b: the vertices
+     *     distanceMode mode: EXACT (miles, same as distanceEarth on their
+     *                        lat/lon), CHORD2 or EQUIRECT
+     */
+    double distance(int a, int b, distanceMode mode = EXACT) const
+    {
+        if (mode == EQUIRECT)
+        {
+            return distanceEquirect(lat[a], lon[a], lat[b], lon[b]);
+        }
+
+        double dx = x[a] - x[b];
+        double dy = y[a] - y[b];
+        double dz = z[a] - z[b];
+        double chord2 = dx * dx + dy * dy + dz * dz;
+
+        return mode == CHORD2 ? chord2 : chord2ToMiles(chord2);
+    }
+
+    /**
+     * distances - distance from one vertex to every vertex, several at a
+     *     time (distanceEarthBatch)
+     * Params:
+     *     int from: vertex to measure from
+     *     double* out: size() distances, by ID
+     *     distanceMode mode: as for distance()
+     */
+    void distances(int from, double *out, distanceMode mode = EXACT) const
+    {
+        if (mode == EQUIRECT)
+        {
+            for (int i = 0; i < size(); i++)
+            {
+                out[i] = distanceEquirect(lat[from], lon[from], lat[i], lon[i]);
+            }
+            return;
+        }
+        distanceEarthBatch(x[from], y[from], z[from], x.data(), y.data(), z.data(), NULL, x.size(), out, mode);
+    }
+
+    /**
+     * distances - distance from one vertex to a list of vertices
+     * Params:
+     *     int from: vertex to measure from
+     *     const vector<int>& ids: vertices to measure to
+     *     double* out: ids.size() distances, in the order of ids
+     *     distanceMode mode: as for distance()
+     */
+    void distances(int from, const vector<int> &ids, double *out, distanceMode mode = EXACT) const
+    {
+        if (mode == EQUIRECT)
+        {
+            for (size_t i = 0; i < ids.size(); i++)
+            {
+                out[i] = distanceEquirect(lat[from], lon[from], lat[ids[i]], lon[ids[i]]);
+            }
+            return;
+        }
+        distanceEarthBatch(x[from], y[from], z[from], x.data(), y.data(), z.data(), ids.data(), ids.size(), out, mode);
+    }
+};